@@ -0,0 +1,48 @@
+/** \file FreeRTOSConfig.h
+*
+* \brief FreeRTOS configuration for the FreeRTOS build configuration.
+*
+* The kernel uses TCC1 as tick generator (see board.h). TCC0 is used
+* by the keypad scan interrupt. All kernel objects are allocated
+* statically, hence no heap implementation is linked.
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <avr/io.h>
+
+#define configUSE_PREEMPTION                    1
+#define configUSE_IDLE_HOOK                     0
+#define configUSE_TICK_HOOK                     0
+#define configCPU_CLOCK_HZ                      ((unsigned long)F_CPU)
+#define configTICK_RATE_HZ                      ((TickType_t)1000)
+#define configMAX_PRIORITIES                    4
+#define configMINIMAL_STACK_SIZE                ((unsigned short)128)
+#define configMAX_TASK_NAME_LEN                 8
+#define configUSE_TRACE_FACILITY                0
+#define configUSE_16_BIT_TICKS                  1
+#define configTICK_TYPE_WIDTH_IN_BITS           TICK_TYPE_WIDTH_16_BITS
+#define configIDLE_SHOULD_YIELD                 1
+#define configUSE_MUTEXES                       0
+#define configUSE_TIMERS                        0
+#define configUSE_CO_ROUTINES                   0
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        0
+#define configCHECK_FOR_STACK_OVERFLOW          0
+
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_vTaskDelayUntil                 1
+#define INCLUDE_vTaskDelete                     0
+#define INCLUDE_vTaskSuspend                    0
+#define INCLUDE_vTaskPrioritySet                0
+#define INCLUDE_uxTaskPriorityGet               0
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,90 @@
+/*
+ * baud.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "baud.h"
+
+#define LIMIT ((1<<USART_BSEL_BITS)-1)
+
+/* freq*2^7 must fit into an unsigned long, i.e. freq up to 33 MHz. */
+int usart_bsel(long freq, long baud, int bscale, int clk2x)
+{
+	unsigned long div = ((clk2x) ? 8UL : 16UL)*baud;
+	unsigned long bsel;
+	if (baud <= 0) return -1;
+	if (bscale >= 0) {
+		if (div > ((unsigned long)freq>>bscale)) return -1;
+		div <<= bscale;
+		bsel = ((unsigned long)freq+div/2)/div-1;
+	}
+	else {
+		bsel = (((unsigned long)freq<<-bscale)+div/2)/div;
+		if (bsel < (1UL<<-bscale)) return -1;
+		bsel -= 1UL<<-bscale;
+	}
+	return (bsel > LIMIT) ? -1 : (int)bsel;
+}
+
+long usart_baud(long freq, int bsel, int bscale, int clk2x)
+{
+	unsigned long div = (clk2x) ? 8UL : 16UL;
+	if (bsel < 0 || bsel > LIMIT) return -1;
+	if (bscale >= 0) {
+		div *= (unsigned long)(bsel+1)<<bscale;
+		return ((unsigned long)freq+div/2)/div;
+	}
+	div *= bsel+(1UL<<-bscale);
+	return (((unsigned long)freq<<-bscale)+div/2)/div;
+}
+
+/* The divisor F_CPU/baud of the register values in units of 1/128. */
+static unsigned long usart_divisor(int bsel, int bscale, int clk2x)
+{
+	unsigned long div = (clk2x) ? 8UL : 16UL;
+	if (bscale >= 0) return (div*(bsel+1))<<(bscale+7);
+	return (div*(bsel+(1UL<<-bscale)))<<(bscale+7);
+}
+
+/* The candidates are ranked by the error of their rate in ppm. The
+ * rate from usart_baud is rounded to whole baud, which hides the
+ * differences at low rates, and the products need 64 bits. */
+int usart_params(long freq, long baud, int* bsel, int* bscale, int* clk2x)
+{
+	int b, s, x;
+	uint64_t ideal, actual;
+	unsigned long error, best = 0;
+	long deviation;
+	*bsel = -1;
+	if (baud <= 0 || baud > freq/8) return USART_BAUD_INVALID;
+	ideal = (uint64_t)freq<<7;
+	/* On equal error normal speed is preferred because it samples 16
+	 * times per bit, and integer BSCALE over fractional. */
+	for (x=0;x<=1;x++) {
+		for (s=7;s>=-7;s--) {
+			b = usart_bsel(freq,baud,s,x);
+			if (b < 0) continue;
+			actual = (uint64_t)usart_divisor(b,s,x)*baud;
+			error = ((actual > ideal) ? actual-ideal : ideal-actual)*1000000UL/actual;
+			if (*bsel < 0 || error < best) {
+				best = error;
+				*bsel = b;
+				*bscale = s;
+				*clk2x = x;
+			}
+		}
+	}
+	if (*bsel < 0 || best > 1000000UL/8) {
+		*bsel = -1;
+		return USART_BAUD_INVALID;
+	}
+	deviation = 1000*(usart_baud(freq,*bsel,*bscale,*clk2x)-baud)/baud;
+	if (labs(deviation) > USART_BAUD_TOLERANCE) *bsel = -1;
+	return deviation;
+}
@@ -0,0 +1,80 @@
+/** \file baud.h
+*
+* \brief Calculation of the baud rate registers of the USARTs.
+*
+* The functions do not depend on the hardware, so the calculation can
+* also be checked on the host (see padtool baud).
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef BAUD_H_
+#define BAUD_H_
+
+#define USART_BSEL_BITS 12
+#define USART_BAUD_TOLERANCE 20
+#define USART_BAUD_INVALID 1000
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Calculate BSEL.</summary>
+/// <remarks>
+/// Calculates the corresponding value for BSEL for a given F_CPU, baud
+/// rate, BSCALE and clock rate.
+/// </remarks>
+/// <param name="freq">The given value of F_CPU.</param>
+/// <param name="baud">The desired baud rate.</param>
+/// <param name="bscale">The desired value for BSCALE.</param>
+/// <param name="clk2x">Indicates if clock rate should be doubled.</param>
+/// <returns>
+/// The value of BSEL to get the desired baud rate or -1 if it does not
+/// fit into USART_BSEL_BITS bits.
+/// </returns>
+int usart_bsel(long freq, long baud, int bscale, int clk2x);
+
+/// <summary>Calculate baud rate.</summary>
+/// <remarks>
+/// Calculates the resulting baud rate for a given F_CPU, BSEL, BSCALE and
+/// clock rate.
+/// </remarks>
+/// <param name="freq">The given value of F_CPU.</param>
+/// <param name="bsel">The given value of BSEL.</param>
+/// <param name="bscale">The given value of BSCALE.</param>
+/// <param name="clk2x">Indicates if clock rate should be doubled.</param>
+/// <returns>The resulting baud rate for the given parameters.</returns>
+long usart_baud(long freq, int bsel, int bscale, int clk2x);
+
+/// <summary>Calculate BSEL, BSCALE and clock rate.</summary>
+/// <remarks>
+/// Determines the the best values for BSEL, BSCALE and CLK2X for a given
+/// F_CPU and baud rate. All combinations are tried and the one with the
+/// smallest deviation is taken. Rates up to F_CPU/8 are possible, e.g.
+/// 2 Mbaud at 16 MHz or 4 Mbaud at 32 MHz. Sets BSEL to -1 if no valid
+/// value can be found or if the resulting baud rate lies outside the
+/// given tolerance of USART_BAUD_TOLERANCE which is specified in per
+/// mill.
+/// </remarks>
+/// <param name="freq">The given value of F_CPU.</param>
+/// <param name="baud">The desired baud rate.</param>
+/// <param name="bsel">The resulting value for BSEL.</param>
+/// <param name="bscale">The resulting value for BSCALE.</param>
+/// <param name="clk2x">The resulting value for CLK2X.</param>
+/// <returns>
+/// The deviation of resulting baud rate from the given baud rate
+/// in per mill.
+/// </returns>
+int usart_params(long freq, long baud, int* bsel, int* bscale, int* clk2x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BAUD_H_ */
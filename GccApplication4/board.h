@@ -15,8 +15,8 @@
 * * \ref oscillators
 *
 * \author    Wolfgang Neff
-* \version   1.6
-* \date      2017-04-04
+* \version   1.7
+* \date      2026-10-19
 *
 * \par History
 *      Created: 2013-07-16 \n
@@ -25,11 +25,13 @@
 *      Modified: 2016-06-11 \n
 *      Modified: 2016-11-26 \n
 *      Modified: 2017-06-04 \n
-*      Modified: 2017-08-04
+*      Modified: 2017-08-04 \n
+*      Modified: 2026-10-19
 *
 * \note
 *      **USB:** Parameter for the USART-to-USB gateway: 115200 8N1. \n
-*      **F_CPU:** Default 2000000. Use default or set it via Project/Properties/Toolchain/Compiler/Symbols. \n
+*      **F_CPU:** Default 2000000. Use default or set it via Project/Properties/Toolchain/Compiler/Symbols.
+*      With F_CPU=32000000 main() switches to the 32 MHz oscillator (OSC_INIT_32MHZ()). \n
 *      **FreeROTS:** TCC1 used as tick generator. Default: 1000 low level interrupts ticks per second.
 */
 
@@ -96,14 +98,92 @@
 #define GPIO_PIN6CTRL GPIO_HIGH_PORT.PIN0CTRL
 #define GPIO_PIN7CTRL GPIO_HIGH_PORT.PIN1CTRL
 
+/****** Virtual ports ******/
+#define GPIO_LOW_VPORT VPORT0
+#define GPIO_HIGH_VPORT VPORT1
+#define GPIO_VPORT_MAP (PORTCFG_VP0MAP_PORTD_gc | PORTCFG_VP1MAP_PORTR_gc)
+
+/// \def GPIO_VPORT_INIT()
+/// <summary>Map the GPIO ports to virtual ports</summary>
+/// <remarks>
+/// Maps PORTD to VPORT0 and PORTR to VPORT1. Virtual ports lie in the
+/// I/O space and are accessed with single cycle IN/OUT/SBI/CBI
+/// instructions. Must be called before any of the GPIO and button
+/// macros which read or write the virtual ports.
+/// </remarks>
+#define GPIO_VPORT_INIT() (PORTCFG.VPCTRLA = GPIO_VPORT_MAP)
+
 /// \def GPIO_READ()
 /// <summary>Read all GPIO pins</summary>
-#define GPIO_READ() ((GPIO_LOW_PORT.IN & GPIO_LOW_PINS_gm) | ((GPIO_HIGH_PORT.IN << GPIO_HIGH_PINS_gp) & GPIO_HIGH_PINS_gm))
+#define GPIO_READ() ((GPIO_LOW_VPORT.IN & GPIO_LOW_PINS_gm) | ((GPIO_HIGH_VPORT.IN << GPIO_HIGH_PINS_gp) & GPIO_HIGH_PINS_gm))
 
 /// \def GPIO_WRITE(VAL)
 /// <summary>Set all GPIO pins</summary>
+/// <remarks>
+/// Toggles the pins which differ from the value with a single store
+/// per port, so the pins of a port change at the same time. Other pins
+/// of these ports are not touched, even if an interrupt changes them.
+/// </remarks>
 /// <param name="VAL">The new value for the pins.</param>
-#define GPIO_WRITE(VAL) GPIO_LOW_PORT.OUT = (VAL) & GPIO_LOW_PINS_gm; GPIO_HIGH_PORT.OUT = (((VAL) & GPIO_HIGH_PINS_gm) >> GPIO_HIGH_PINS_gp);
+#define GPIO_WRITE(VAL) do { \
+	GPIO_LOW_PORT.OUTTGL = (GPIO_LOW_VPORT.OUT ^ (VAL)) & GPIO_LOW_PINS_gm; \
+	GPIO_HIGH_PORT.OUTTGL = (GPIO_HIGH_VPORT.OUT ^ (((VAL) & GPIO_HIGH_PINS_gm) >> GPIO_HIGH_PINS_gp)) & (GPIO_HIGH_PINS_gm >> GPIO_HIGH_PINS_gp); \
+} while (0)
+
+/// \def GPIO_SET(MASK)
+/// <summary>Set GPIO pins</summary>
+/// <remarks>Atomic and interrupt safe for any number of pins.</remarks>
+/// <param name="MASK">The pins to be set.</param>
+#define GPIO_SET(MASK) do { \
+	GPIO_LOW_PORT.OUTSET = (MASK) & GPIO_LOW_PINS_gm; \
+	GPIO_HIGH_PORT.OUTSET = ((MASK) & GPIO_HIGH_PINS_gm) >> GPIO_HIGH_PINS_gp; \
+} while (0)
+
+/// \def GPIO_CLEAR(MASK)
+/// <summary>Clear GPIO pins</summary>
+/// <remarks>Atomic and interrupt safe for any number of pins.</remarks>
+/// <param name="MASK">The pins to be cleared.</param>
+#define GPIO_CLEAR(MASK) do { \
+	GPIO_LOW_PORT.OUTCLR = (MASK) & GPIO_LOW_PINS_gm; \
+	GPIO_HIGH_PORT.OUTCLR = ((MASK) & GPIO_HIGH_PINS_gm) >> GPIO_HIGH_PINS_gp; \
+} while (0)
+
+/// \def GPIO_TOGGLE(MASK)
+/// <summary>Toggle GPIO pins</summary>
+/// <remarks>Atomic and interrupt safe for any number of pins.</remarks>
+/// <param name="MASK">The pins to be toggled.</param>
+#define GPIO_TOGGLE(MASK) do { \
+	GPIO_LOW_PORT.OUTTGL = (MASK) & GPIO_LOW_PINS_gm; \
+	GPIO_HIGH_PORT.OUTTGL = ((MASK) & GPIO_HIGH_PINS_gm) >> GPIO_HIGH_PINS_gp; \
+} while (0)
+
+/// \def GPIO_LOW_PIN_SET(BM)
+/// <summary>Set a single pin of the low GPIO port</summary>
+/// <remarks>
+/// Compiles to a single SBI instruction if BM is a constant with one
+/// bit set. Use GPIO_SET for more than one pin.
+/// </remarks>
+/// <param name="BM">The bit mask of the pin.</param>
+#define GPIO_LOW_PIN_SET(BM) (GPIO_LOW_VPORT.OUT |= (BM))
+
+/// \def GPIO_LOW_PIN_CLEAR(BM)
+/// <summary>Clear a single pin of the low GPIO port</summary>
+/// <remarks>
+/// Compiles to a single CBI instruction if BM is a constant with one
+/// bit set. Use GPIO_CLEAR for more than one pin.
+/// </remarks>
+/// <param name="BM">The bit mask of the pin.</param>
+#define GPIO_LOW_PIN_CLEAR(BM) (GPIO_LOW_VPORT.OUT &= ~(BM))
+
+/// \def GPIO_HIGH_PIN_SET(BM)
+/// <summary>Set a single pin of the high GPIO port</summary>
+/// <param name="BM">The bit mask of the pin.</param>
+#define GPIO_HIGH_PIN_SET(BM) (GPIO_HIGH_VPORT.OUT |= (BM))
+
+/// \def GPIO_HIGH_PIN_CLEAR(BM)
+/// <summary>Clear a single pin of the high GPIO port</summary>
+/// <param name="BM">The bit mask of the pin.</param>
+#define GPIO_HIGH_PIN_CLEAR(BM) (GPIO_HIGH_VPORT.OUT &= ~(BM))
 /// @}
 
 /** @defgroup leds LEDs
@@ -181,6 +261,8 @@
 /****** Active low push buttons ******/
 #define BUTTON_LOW_PORT PORTD
 #define BUTTON_HIGH_PORT PORTR
+#define BUTTON_LOW_VPORT GPIO_LOW_VPORT
+#define BUTTON_HIGH_VPORT GPIO_HIGH_VPORT
 #define BUTTON_LOW_PINS_gp 0
 #define BUTTON_LOW_PINS_gm 0x3F
 #define BUTTON_HIGH_PINS_gp 6
@@ -215,7 +297,8 @@
 
 /// \def BUTTONS_READ()
 /// <summary>Read all push buttons</summary>
-#define BUTTONS_READ() ((BUTTON_LOW_PORT.IN & BUTTON_LOW_PINS_gm) | ((BUTTON_HIGH_PORT.IN << BUTTON_HIGH_PINS_gp) & BUTTON_HIGH_PINS_gm))
+/// <remarks>Requires GPIO_VPORT_INIT().</remarks>
+#define BUTTONS_READ() ((BUTTON_LOW_VPORT.IN & BUTTON_LOW_PINS_gm) | ((BUTTON_HIGH_VPORT.IN << BUTTON_HIGH_PINS_gp) & BUTTON_HIGH_PINS_gm))
 
 /// \def BUTTON_PRESSED(BUTTON)
 /// <summary>Check if push button is pressed</summary>
@@ -227,7 +310,12 @@
  <summary>Constants for the USART-to-USB gateway.</summary>
  <remarks>
  USARTC0 is connected with a USART-to-USB gateway.
- The configuration for the gateway is: 115200 8N1.
+ The configuration for the gateway is: 115200 8N1. \n
+ The gateway has no handshake lines. For hardware flow control an
+ external adapter is connected to jumper J4 (PC0 RTS, PC1 CTS, PC2 RXD,
+ PC3 TXD). Both handshake lines are active low. \n
+ USARTC1 on jumper J4 (PC6 RXD, PC7 TXD) is an auxiliary port which
+ mirrors the key events. It has no handshake lines.
  </remarks>
 @{ */
 /****** USART-to-USB gateway ******/
@@ -235,6 +323,8 @@
 #define USART0_TX_PIN_bm PIN3_bm
 #define USART1_RX_PIN_bm PIN6_bm
 #define USART1_TX_PIN_bm PIN7_bm
+#define USART0_RTS_PIN_bm PIN0_bm
+#define USART0_CTS_PIN_bm PIN1_bm
 
 #define USB_USART_PORT PORTC
 #define USB_USART_MODULE USARTC0
@@ -242,6 +332,19 @@
 #define USB_USART_TX_PIN_bm USART0_TX_PIN_bm
 #define USB_USART_RXC_vect USARTC0_RXC_vect
 #define USB_USART_DRE_vect USARTC0_DRE_vect
+#define USB_USART_RTS_PIN_bm USART0_RTS_PIN_bm
+#define USB_USART_CTS_PIN_bm USART0_CTS_PIN_bm
+#define USB_USART_CTS_PINCTRL PORTC.PIN1CTRL
+#define USB_USART_CTS_vect PORTC_INT0_vect
+#define USB_USART_RX_CHMUX EVSYS_CHMUX_PORTC_PIN2_gc
+
+#define AUX_USART_PORT PORTC
+#define AUX_USART_MODULE USARTC1
+#define AUX_USART_RX_PIN_bm USART1_RX_PIN_bm
+#define AUX_USART_TX_PIN_bm USART1_TX_PIN_bm
+#define AUX_USART_RXC_vect USARTC1_RXC_vect
+#define AUX_USART_DRE_vect USARTC1_DRE_vect
+#define AUX_USART_RX_CHMUX EVSYS_CHMUX_PORTC_PIN6_gc
 
 #define USB_USART_BAUDRATE 115200
 #define USB_USART_CONFIG (USART_CHSIZE_8BIT_gc | USART_PMODE_DISABLED_gc)
@@ -364,6 +467,23 @@
 /****** Default oscillator ******/
 #define OSC_DEFAULT_HZ OSC_INTERNAL_2HZ
 
+/// \def OSC_INIT_32MHZ()
+/// <summary>Switch the system clock to the internal 32 MHz oscillator</summary>
+/// <remarks>
+/// Enables the 32 MHz and the 32 kHz oscillators, waits until both are
+/// stable and selects the 32 MHz oscillator as system clock. The DFLL
+/// calibrates it against the 32 kHz oscillator which keeps the error
+/// below the tolerance of high baud rates. F_CPU must be set to
+/// OSC_INTERNAL_32HZ.
+/// </remarks>
+#define OSC_INIT_32MHZ() do { \
+	OSC.CTRL |= OSC_RC32MEN_bm | OSC_RC32KEN_bm; \
+	while ((OSC.STATUS & (OSC_RC32MRDY_bm | OSC_RC32KRDY_bm)) != (OSC_RC32MRDY_bm | OSC_RC32KRDY_bm)); \
+	DFLLRC32M.CTRL = DFLL_ENABLE_bm; \
+	CCP = CCP_IOREG_gc; \
+	CLK.CTRL = CLK_SCLKSEL_RC32M_gc; \
+} while (0)
+
 /****** F_CPU ******/
 #ifndef F_CPU
 #define F_CPU OSC_INTERNAL_2HZ
@@ -0,0 +1,83 @@
+/*
+ * capture.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */ 
+
+#include <stddef.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "board.h"
+#include "pad.h"
+#include "scan.h"
+#include "capture.h"
+
+static capture_t capture;
+static uint16_t capture_runs[CAPTURE_RUNS_MAX];
+
+/* Waits for the next sampling period and reads the sense lines. */
+static inline uint8_t capture_sample(void)
+{
+	while (!(CAPTURE_TIMER.INTFLAGS & TC0_OVFIF_bm));
+	CAPTURE_TIMER.INTFLAGS = TC0_OVFIF_bm;
+	return PAD_VPORT.IN & PAD_SENSE_gm;
+}
+
+const capture_t* capture_run(uint8_t line, uint16_t rate, uint16_t timeout, uint32_t samples)
+{
+	uint32_t wait = (uint32_t)rate*timeout/1000;
+	uint16_t run = 0;
+	uint8_t value, previous, sreg;
+	capture.line = line;
+	capture.rate = rate;
+	capture.runs = 0;
+	capture.samples = 0;
+	capture.run = capture_runs;
+	if (!CAPTURE_RATE_VALID(rate)) return NULL;
+
+	scan_pause(1);
+	PAD_VPORT.OUT = PAD_LINE_bm(line);
+	CAPTURE_TIMER.CTRLA = TC_CLKSEL_OFF_gc;
+	CAPTURE_TIMER.CTRLB = TC_WGMODE_NORMAL_gc;
+	CAPTURE_TIMER.CNT = 0;
+	CAPTURE_TIMER.PER = F_CPU/rate - 1;
+	CAPTURE_TIMER.INTFLAGS = TC0_OVFIF_bm;
+	CAPTURE_TIMER.CTRLA = TC_CLKSEL_DIV1_gc;
+
+	/* The trigger is awaited with interrupts enabled, an interrupt only
+	 * delays the detection of the first change. */
+	previous = capture_sample();
+	do {
+		value = capture_sample();
+	} while (value == previous && --wait);
+	sreg = SREG;
+	cli();
+	if (value != previous) {
+		/* The last sample before the change starts the capture. */
+		capture_runs[capture.runs++] = previous << CAPTURE_VALUE_gp;
+		capture.samples = 2;
+		previous = value;
+		while (capture.samples < samples) {
+			value = capture_sample();
+			capture.samples++;
+			if (value == previous && run < CAPTURE_RUN_MAX) {
+				run++;
+				continue;
+			}
+			capture_runs[capture.runs++] = (previous << CAPTURE_VALUE_gp) | run;
+			if (capture.runs >= CAPTURE_RUNS_MAX) break;
+			previous = value;
+			run = 0;
+		}
+		if (capture.runs < CAPTURE_RUNS_MAX) capture_runs[capture.runs++] = (previous << CAPTURE_VALUE_gp) | run;
+	}
+
+	SREG = sreg;
+	CAPTURE_TIMER.CTRLA = TC_CLKSEL_OFF_gc;
+	PAD_VPORT.OUT = 0x00;
+	scan_pause(0);
+	return (capture.samples) ? &capture : NULL;
+}
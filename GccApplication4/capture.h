@@ -0,0 +1,77 @@
+/** \file capture.h
+*
+* \brief Raw capture of the sense lines for bounce characterisation.
+*
+* One drive line of the keypad is activated and its four sense lines
+* are sampled with a fixed rate of up to some ten kilohertz. The
+* samples are stored run length encoded: every run is a 16 bit word
+* whose upper four bits hold the sense lines and whose lower twelve
+* bits hold the length of the run minus one. Long periods without
+* change therefore cost almost no memory.
+*
+* The capture starts with the first change of the sense lines. It ends
+* when the buffer is full or when the given number of samples has been
+* taken. Scanning is paused during the capture. Interrupts stay enabled
+* while waiting for the first change and are disabled from then on to
+* keep the sampling period exact.
+*
+* The runs are stored in a static buffer of CAPTURE_RUNS_MAX words, so
+* that the linker accounts for it. The sampling rate must be at least
+* F_CPU/65536 to fit the period of the timer.
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+#include <stdint.h>
+
+#define CAPTURE_TIMER TCD0
+#ifndef CAPTURE_RUNS_MAX
+#define CAPTURE_RUNS_MAX 1024
+#endif
+#define CAPTURE_RUN_MAX 0x0FFF
+#define CAPTURE_VALUE_gp 12
+#define CAPTURE_LENGTH_gm 0x0FFF
+#define CAPTURE_RATE_VALID(RATE) ((RATE) != 0 && F_CPU/(RATE) <= 65536UL)
+
+#ifndef CAPTURE_DEFAULT_RATE
+#define CAPTURE_DEFAULT_RATE 20000
+#endif
+
+/// <summary>Result of a capture.</summary>
+typedef struct {
+	uint8_t line;         ///< The drive line.
+	uint16_t rate;        ///< The sampling rate in hertz.
+	uint16_t runs;        ///< Number of runs in the buffer, at most CAPTURE_RUNS_MAX.
+	uint32_t samples;     ///< Number of samples taken.
+	const uint16_t *run;  ///< The runs.
+} capture_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Capture the sense lines of a drive line.</summary>
+/// <remarks>
+/// Blocks until the capture has finished or the trigger timed out.
+/// </remarks>
+/// <param name="line">The drive line from 0 to 3.</param>
+/// <param name="rate">The sampling rate in hertz.</param>
+/// <param name="timeout">Time to wait for the first change in milliseconds.</param>
+/// <param name="samples">The maximum number of samples.</param>
+/// <returns>The result or NULL if the trigger timed out or the rate is invalid.</returns>
+const capture_t* capture_run(uint8_t line, uint16_t rate, uint16_t timeout, uint32_t samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAPTURE_H_ */
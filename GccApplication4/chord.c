@@ -0,0 +1,147 @@
+/*
+ * chord.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */
+
+#include "chord.h"
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#define CHORD_STEP(chord,I,S) pgm_read_word(&(chord)->table[I].step[S])
+#define CHORD_ID(chord,I) pgm_read_byte(&(chord)->table[I].id)
+#else
+#define CHORD_STEP(chord,I,S) ((chord)->table[I].step[S])
+#define CHORD_ID(chord,I) ((chord)->table[I].id)
+#endif
+
+#define CHORD_QUEUE_MASK (CHORD_QUEUE_SIZE-1)
+
+static void chord_restart(chord_t *chord)
+{
+	chord->lo = 0;
+	chord->hi = chord->count;
+	chord->steps = 0;
+	chord->match = CHORD_NONE;
+}
+
+/* A full queue drops the match. */
+static void chord_finish(chord_t *chord)
+{
+	uint8_t head = (chord->head+1) & CHORD_QUEUE_MASK;
+	if (chord->match != CHORD_NONE && head != chord->tail) {
+		chord->queue[chord->head] = chord->match;
+		chord->head = head;
+	}
+	chord_restart(chord);
+}
+
+/* Narrows the range to the patterns whose next step equals keys. */
+static uint8_t chord_narrow(chord_t *chord, uint16_t keys)
+{
+	uint16_t lo = chord->lo, hi = chord->hi, mid, first;
+	uint8_t step = chord->steps;
+	if (step >= CHORD_STEPS) return 0;
+	while (lo < hi) {
+		mid = lo+(hi-lo)/2;
+		if (CHORD_STEP(chord,mid,step) < keys) lo = mid+1;
+		else hi = mid;
+	}
+	first = lo;
+	hi = chord->hi;
+	while (lo < hi) {
+		mid = lo+(hi-lo)/2;
+		if (CHORD_STEP(chord,mid,step) <= keys) lo = mid+1;
+		else hi = mid;
+	}
+	if (first == lo) return 0;
+	chord->lo = first;
+	chord->hi = lo;
+	chord->steps = step+1;
+	return 1;
+}
+
+static void chord_step(chord_t *chord, uint16_t keys)
+{
+	if (!chord_narrow(chord,keys)) {
+		if (chord->steps == 0) return;
+		chord_finish(chord);
+		if (!chord_narrow(chord,keys)) return;
+	}
+	/* Unused steps are zero, so a pattern which ends here is the
+	 * first of the range. */
+	if (chord->steps == CHORD_STEPS || CHORD_STEP(chord,chord->lo,chord->steps) == 0) {
+		chord->match = CHORD_ID(chord,chord->lo);
+		if (chord->hi-chord->lo == 1) chord_finish(chord);
+	}
+}
+
+static uint8_t chord_expired(const chord_t *chord, uint16_t time)
+{
+	return chord->steps && chord->timeout && (uint16_t)(time-chord->time) >= chord->timeout;
+}
+
+uint8_t chord_init(chord_t *chord, const chord_pattern_t *table, uint16_t count, uint16_t timeout)
+{
+	uint16_t i, a, b;
+	uint8_t s, valid = 1, order;
+	chord->table = table;
+	chord->count = count;
+	for (i=0;i<count && valid;i++) {
+		valid = CHORD_STEP(chord,i,0) != 0 && CHORD_ID(chord,i) != CHORD_NONE;
+		for (s=1,order=(i==0);s<CHORD_STEPS && valid;s++) {
+			if (CHORD_STEP(chord,i,s-1) == 0 && CHORD_STEP(chord,i,s) != 0) valid = 0;
+		}
+		for (s=0;s<CHORD_STEPS && !order;s++) {
+			a = CHORD_STEP(chord,i-1,s);
+			b = CHORD_STEP(chord,i,s);
+			if (a > b) break;
+			if (a < b) order = 1;
+		}
+		if (!order) valid = 0;
+	}
+	if (!valid) chord->count = 0;
+	chord->head = chord->tail = 0;
+	chord_timeout(chord,timeout);
+	return valid;
+}
+
+void chord_timeout(chord_t *chord, uint16_t timeout)
+{
+	chord->timeout = timeout;
+	chord->keys = 0;
+	chord->held = 0;
+	chord_restart(chord);
+}
+
+void chord_event(chord_t *chord, uint16_t pressed, uint16_t released, uint16_t time)
+{
+	if (pressed && !chord->keys && chord_expired(chord,time)) chord_finish(chord);
+	chord->keys |= pressed;
+	chord->held = (chord->held | pressed) & ~released;
+	if (chord->held || !chord->keys) return;
+	chord->time = time;
+	chord_step(chord,chord->keys);
+	chord->keys = 0;
+}
+
+uint8_t chord_read(chord_t *chord, uint16_t time)
+{
+	uint8_t id;
+	if (!chord->keys && chord_expired(chord,time)) chord_finish(chord);
+	if (chord->head == chord->tail) return CHORD_NONE;
+	id = chord->queue[chord->tail];
+	chord->tail = (chord->tail+1) & CHORD_QUEUE_MASK;
+	return id;
+}
+
+int chord_compare(const chord_pattern_t *a, const chord_pattern_t *b)
+{
+	uint8_t s;
+	for (s=0;s<CHORD_STEPS;s++) {
+		if (a->step[s] != b->step[s]) return (a->step[s] < b->step[s]) ? -1 : 1;
+	}
+	return 0;
+}
@@ -0,0 +1,127 @@
+/** \file chord.h
+*
+* \brief Recognition of key chords and sequences.
+*
+* A pattern is a sequence of up to CHORD_STEPS steps. A step is the
+* set of keys pressed until all keys are released again, so a single
+* key and a chord of several keys are both one step. Unused steps at
+* the end of a pattern are zero.
+*
+* The patterns are stored in a table in PROGMEM which is sorted
+* by the steps as unsigned numbers, first step first. The table forms
+* an implicit trie: the patterns which begin with the steps entered so
+* far are a contiguous range of the table. Every step narrows the range
+* by two binary searches, so a step costs at most 2*log2(n) table reads
+* and no RAM besides <c>chord_t</c> is needed.
+*
+* A pattern matches when its last step has been entered. If no longer
+* pattern begins with it, its identifier is reported at once. Otherwise
+* the recognizer waits for the next step. When the time between two
+* steps exceeds the timeout or a step continues no pattern, the longest
+* pattern matched so far is reported and the steps after it are
+* discarded. A step which continues no pattern is then tried as the
+* first step of a new sequence.
+*
+* This module depends on nothing but <c>stdint.h</c> and is also
+* compiled into the host tools, where the table is read from RAM.
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef CHORD_H_
+#define CHORD_H_
+
+#include <stdint.h>
+
+#ifndef CHORD_STEPS
+#define CHORD_STEPS 8
+#endif
+
+#define CHORD_NONE 0
+#define CHORD_QUEUE_SIZE 4
+
+/// <summary>A pattern.</summary>
+typedef struct {
+	uint16_t step[CHORD_STEPS];  ///< Keys of each step, zero if unused.
+	uint8_t id;                  ///< Identifier reported on a match, not CHORD_NONE.
+} chord_pattern_t;
+
+/// <summary>State of the recognizer.</summary>
+typedef struct {
+	const chord_pattern_t *table;     ///< The sorted patterns.
+	uint16_t count;                   ///< Number of patterns.
+	uint16_t lo;                      ///< First pattern of the range.
+	uint16_t hi;                      ///< Pattern after the range.
+	uint8_t steps;                    ///< Steps entered so far.
+	uint8_t match;                    ///< Longest pattern matched so far.
+	uint16_t keys;                    ///< Keys pressed in the current step.
+	uint16_t held;                    ///< Keys still held.
+	uint16_t time;                    ///< Time of the last step in milliseconds.
+	uint16_t timeout;                 ///< Maximum time between steps, 0 waits forever.
+	uint8_t queue[CHORD_QUEUE_SIZE];  ///< Matches not read yet.
+	uint8_t head;                     ///< Write index of the queue.
+	uint8_t tail;                     ///< Read index of the queue.
+} chord_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Initialize the recognizer.</summary>
+/// <remarks>
+/// The table is checked: it must be sorted without duplicates, every
+/// pattern needs at least one step, no used step may follow an unused
+/// one and no identifier may be CHORD_NONE. An invalid table is
+/// replaced by an empty one.
+/// </remarks>
+/// <param name="chord">The recognizer.</param>
+/// <param name="table">The patterns in PROGMEM.</param>
+/// <param name="count">The number of patterns.</param>
+/// <param name="timeout">Maximum time between steps in milliseconds, 0 waits forever.</param>
+/// <returns>True if the table is valid.</returns>
+uint8_t chord_init(chord_t *chord, const chord_pattern_t *table, uint16_t count, uint16_t timeout);
+
+/// <summary>Change the timeout.</summary>
+/// <remarks>Discards the steps entered so far.</remarks>
+/// <param name="chord">The recognizer.</param>
+/// <param name="timeout">Maximum time between steps in milliseconds, 0 waits forever.</param>
+void chord_timeout(chord_t *chord, uint16_t timeout);
+
+/// <summary>Process a key event.</summary>
+/// <remarks>
+/// Completes a step when the last held key is released. Matches are
+/// queued and read with <c>chord_read</c>.
+/// </remarks>
+/// <param name="chord">The recognizer.</param>
+/// <param name="pressed">The newly pressed keys.</param>
+/// <param name="released">The newly released keys.</param>
+/// <param name="time">The time of the event in milliseconds.</param>
+void chord_event(chord_t *chord, uint16_t pressed, uint16_t released, uint16_t time);
+
+/// <summary>Read the next match.</summary>
+/// <remarks>
+/// Also applies the timeout, so it must be called periodically.
+/// </remarks>
+/// <param name="chord">The recognizer.</param>
+/// <param name="time">The current time in milliseconds.</param>
+/// <returns>The identifier of the pattern or CHORD_NONE.</returns>
+uint8_t chord_read(chord_t *chord, uint16_t time);
+
+/// <summary>Compare two patterns in RAM.</summary>
+/// <remarks>Defines the order of the table.</remarks>
+/// <param name="a">The first pattern.</param>
+/// <param name="b">The second pattern.</param>
+/// <returns>Less than, equal to or greater than zero.</returns>
+int chord_compare(const chord_pattern_t *a, const chord_pattern_t *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHORD_H_ */
@@ -0,0 +1,30 @@
+/*
+ * dispatch.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */
+
+#include "pad.h"
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#define DISPATCH_MASK(table,I) pgm_read_word(&(table)[I].mask)
+#define DISPATCH_HANDLER(table,I) ((void (*)(const scan_event_t*))pgm_read_ptr(&(table)[I].handler))
+#else
+#define DISPATCH_MASK(table,I) ((table)[I].mask)
+#define DISPATCH_HANDLER(table,I) ((table)[I].handler)
+#endif
+
+uint8_t pad_dispatch(const pad_subscriber_t *table, uint8_t count, const scan_event_t *event)
+{
+	uint16_t keys = event->pressed | event->released;
+	uint8_t i, called = 0;
+	for (i=0;i<count;i++) {
+		if (!(DISPATCH_MASK(table,i) & keys)) continue;
+		DISPATCH_HANDLER(table,i)(event);
+		called++;
+	}
+	return called;
+}
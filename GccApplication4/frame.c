@@ -0,0 +1,69 @@
+/*
+ * frame.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */ 
+
+#include "frame.h"
+
+enum { FRAME_IDLE, FRAME_TYPE, FRAME_LENGTH, FRAME_PAYLOAD, FRAME_CHECKSUM };
+
+uint8_t frame_encode(uint8_t *buffer, uint8_t type, const uint8_t *payload, uint8_t length)
+{
+	uint8_t i, sum = type + length;
+	buffer[0] = FRAME_START;
+	buffer[1] = type;
+	buffer[2] = length;
+	for (i=0;i<length;i++) {
+		buffer[FRAME_HEADER_SIZE+i] = payload[i];
+		sum += payload[i];
+	}
+	buffer[FRAME_HEADER_SIZE+length] = -sum;
+	return length+FRAME_OVERHEAD;
+}
+
+uint8_t frame_event(uint8_t *buffer, uint16_t state, uint16_t pressed, uint16_t released, uint16_t time)
+{
+	uint8_t payload[FRAME_EVENT_SIZE];
+	payload[0] = state & 0xFF;
+	payload[1] = state >> 8;
+	payload[2] = pressed & 0xFF;
+	payload[3] = pressed >> 8;
+	payload[4] = released & 0xFF;
+	payload[5] = released >> 8;
+	payload[6] = time & 0xFF;
+	payload[7] = time >> 8;
+	return frame_encode(buffer,FRAME_EVENT,payload,FRAME_EVENT_SIZE);
+}
+
+uint8_t frame_decode(frame_decoder_t *decoder, uint8_t c)
+{
+	switch (decoder->state) {
+		case FRAME_IDLE:
+			if (c == FRAME_START) decoder->state = FRAME_TYPE;
+			break;
+		case FRAME_TYPE:
+			decoder->type = c;
+			decoder->sum = c;
+			decoder->state = FRAME_LENGTH;
+			break;
+		case FRAME_LENGTH:
+			decoder->length = c;
+			decoder->index = 0;
+			decoder->sum += c;
+			if (c > FRAME_PAYLOAD_MAX) decoder->state = FRAME_IDLE;
+			else decoder->state = (c) ? FRAME_PAYLOAD : FRAME_CHECKSUM;
+			break;
+		case FRAME_PAYLOAD:
+			decoder->payload[decoder->index++] = c;
+			decoder->sum += c;
+			if (decoder->index >= decoder->length) decoder->state = FRAME_CHECKSUM;
+			break;
+		case FRAME_CHECKSUM:
+			decoder->state = FRAME_IDLE;
+			return (uint8_t)(decoder->sum + c) == 0;
+	}
+	return 0;
+}
@@ -0,0 +1,121 @@
+/** \file frame.h
+*
+* \brief Framed binary output format.
+*
+* A frame consists of the start byte FRAME_START, the type, the length
+* of the payload, the payload and a checksum. The checksum is chosen so
+* that the sum of type, length, payload and checksum is zero modulo
+* 256. Multi-byte values in the payload are little endian.
+*
+* This module depends on nothing but <c>stdint.h</c> and is also
+* compiled into the host tools.
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#include <stdint.h>
+
+#define FRAME_START 0x7E
+#define FRAME_HEADER_SIZE 3
+#define FRAME_OVERHEAD (FRAME_HEADER_SIZE+1)
+#define FRAME_PAYLOAD_MAX 32
+#define FRAME_SIZE_MAX (FRAME_PAYLOAD_MAX+FRAME_OVERHEAD)
+
+/// \def FRAME_EVENT
+/// <summary>Key event.</summary>
+/// <remarks>
+/// Payload: debounced state, pressed keys, released keys and the time
+/// of the scan in milliseconds (16 bit each).
+/// </remarks>
+#define FRAME_EVENT 'E'
+#define FRAME_EVENT_SIZE 8
+
+/// \def FRAME_CAPTURE
+/// <summary>Raw capture.</summary>
+/// <remarks>
+/// Payload: up to 16 runs of 16 bit each. The upper four bits of a run
+/// hold the sense lines, the lower twelve bits the length minus one.
+/// </remarks>
+#define FRAME_CAPTURE 'C'
+
+/// \def FRAME_TRACE
+/// <summary>Trace records.</summary>
+/// <remarks>
+/// Payload: up to 10 records of three bytes each, the trace point and
+/// the 16 bit time stamp.
+/// </remarks>
+#define FRAME_TRACE 'T'
+
+/// \def FRAME_MATCH
+/// <summary>Match of a chord or sequence.</summary>
+/// <remarks>
+/// Payload: the identifier of the pattern and the time of the match in
+/// milliseconds (16 bit).
+/// </remarks>
+#define FRAME_MATCH 'M'
+#define FRAME_MATCH_SIZE 3
+
+/// \def FRAME_REPORT
+/// <summary>Periodic report of the pressed keys.</summary>
+/// <remarks>
+/// Payload: sequence counter, modifiers and six key codes (see
+/// report.h).
+/// </remarks>
+#define FRAME_REPORT 'R'
+#define FRAME_REPORT_SIZE 8
+
+/// <summary>Decoder for frames.</summary>
+typedef struct {
+	uint8_t state;                       ///< Position within the frame.
+	uint8_t type;                        ///< Type of the frame.
+	uint8_t length;                      ///< Length of the payload.
+	uint8_t index;                       ///< Bytes of the payload received.
+	uint8_t sum;                         ///< Running checksum.
+	uint8_t payload[FRAME_PAYLOAD_MAX];  ///< The payload.
+} frame_decoder_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Encode a frame.</summary>
+/// <param name="buffer">Receives the frame. Must hold the payload plus FRAME_OVERHEAD bytes.</param>
+/// <param name="type">The type of the frame.</param>
+/// <param name="payload">The payload.</param>
+/// <param name="length">The length of the payload.</param>
+/// <returns>The length of the frame.</returns>
+uint8_t frame_encode(uint8_t *buffer, uint8_t type, const uint8_t *payload, uint8_t length);
+
+/// <summary>Encode a key event.</summary>
+/// <param name="buffer">Receives the frame. Must hold FRAME_EVENT_SIZE plus FRAME_OVERHEAD bytes.</param>
+/// <param name="state">The debounced state.</param>
+/// <param name="pressed">The newly pressed keys.</param>
+/// <param name="released">The newly released keys.</param>
+/// <param name="time">The time of the scan in milliseconds.</param>
+/// <returns>The length of the frame.</returns>
+uint8_t frame_event(uint8_t *buffer, uint16_t state, uint16_t pressed, uint16_t released, uint16_t time);
+
+/// <summary>Decode a frame.</summary>
+/// <remarks>
+/// Feeds one byte into the decoder. Bytes outside of frames and
+/// frames with a wrong checksum are skipped.
+/// </remarks>
+/// <param name="decoder">The decoder.</param>
+/// <param name="c">The received byte.</param>
+/// <returns>True if a complete frame has been received.</returns>
+uint8_t frame_decode(frame_decoder_t *decoder, uint8_t c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FRAME_H_ */
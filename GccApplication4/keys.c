@@ -0,0 +1,65 @@
+/*
+ * keys.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */ 
+
+#include "keys.h"
+
+void keys_init(keys_t *keys, uint8_t depth)
+{
+	keys->state = 0;
+	keys->ghosts = 0;
+	keys_depth(keys,depth);
+}
+
+void keys_depth(keys_t *keys, uint8_t depth)
+{
+	uint8_t i;
+	if (depth < KEYS_DEPTH_MIN) depth = KEYS_DEPTH_MIN;
+	if (depth > KEYS_DEPTH_MAX) depth = KEYS_DEPTH_MAX;
+	for (i=0;i<KEYS_DEPTH_MAX;i++) keys->history[i] = keys->state;
+	keys->depth = depth;
+	keys->index = 0;
+}
+
+uint16_t keys_update(keys_t *keys, uint16_t sample)
+{
+	uint16_t all = 0xFFFF, any = 0x0000;
+	uint8_t i;
+	if (keys_ghost(sample)) {
+		keys->ghosts++;
+		return keys->state;
+	}
+	keys->history[keys->index] = sample;
+	if (++keys->index >= keys->depth) keys->index = 0;
+	for (i=0;i<keys->depth;i++) {
+		all &= keys->history[i];
+		any |= keys->history[i];
+	}
+	keys->state = (keys->state & any) | all;
+	return keys->state;
+}
+
+uint8_t keys_pending(const keys_t *keys)
+{
+	uint8_t i;
+	for (i=0;i<keys->depth;i++) {
+		if (keys->history[i] != keys->state) return 1;
+	}
+	return 0;
+}
+
+uint8_t keys_ghost(uint16_t sample)
+{
+	uint8_t a, b, common;
+	for (a=0;a<16;a+=4) {
+		for (b=a+4;b<16;b+=4) {
+			common = (sample >> a) & (sample >> b) & 0x0F;
+			if (common & (common-1)) return 1;
+		}
+	}
+	return 0;
+}
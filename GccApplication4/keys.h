@@ -0,0 +1,87 @@
+/** \file keys.h
+*
+* \brief Hardware independent keypad logic.
+*
+* This module debounces the raw states returned by <c>pad_scan</c> and
+* suppresses ghost keys. It depends on nothing but <c>stdint.h</c> and
+* is therefore also compiled into the host tools.
+*
+* A key changes its debounced state only after it has been sampled
+* with the same value <c>depth</c> times in a row. Samples which
+* contain a ghost pattern are ignored. A ghost pattern arises in a
+* matrix without diodes if three keys at the corners of a rectangle
+* are pressed: the fourth corner is read as pressed, too.
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef KEYS_H_
+#define KEYS_H_
+
+#include <stdint.h>
+
+#define KEYS_DEPTH_MIN 1
+#define KEYS_DEPTH_MAX 8
+
+#ifndef KEYS_DEFAULT_DEPTH
+#define KEYS_DEFAULT_DEPTH 4
+#endif
+
+/// <summary>State of the debouncer.</summary>
+typedef struct {
+	uint16_t history[KEYS_DEPTH_MAX];  ///< The last raw samples.
+	uint16_t state;                    ///< The debounced state.
+	uint8_t depth;                     ///< Number of equal samples required.
+	uint8_t index;                     ///< Next entry of the history.
+	uint16_t ghosts;                   ///< Number of ignored samples.
+} keys_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Initialize the debouncer.</summary>
+/// <remarks>
+/// Clears the history and the debounced state. The depth is limited
+/// to the range from KEYS_DEPTH_MIN to KEYS_DEPTH_MAX.
+/// </remarks>
+/// <param name="keys">The debouncer.</param>
+/// <param name="depth">Number of equal samples required.</param>
+void keys_init(keys_t *keys, uint8_t depth);
+
+/// <summary>Change the debounce depth.</summary>
+/// <remarks>
+/// The debounced state is kept. The history is filled with it so that
+/// the new depth applies to the following samples.
+/// </remarks>
+/// <param name="keys">The debouncer.</param>
+/// <param name="depth">Number of equal samples required.</param>
+void keys_depth(keys_t *keys, uint8_t depth);
+
+/// <summary>Debounce a new sample.</summary>
+/// <param name="keys">The debouncer.</param>
+/// <param name="sample">The raw state returned by <c>pad_scan</c>.</param>
+/// <returns>The debounced state.</returns>
+uint16_t keys_update(keys_t *keys, uint16_t sample);
+
+/// <summary>Check for a pending change.</summary>
+/// <param name="keys">The debouncer.</param>
+/// <returns>True if a recent sample differs from the debounced state.</returns>
+uint8_t keys_pending(const keys_t *keys);
+
+/// <summary>Check for a ghost pattern.</summary>
+/// <param name="sample">The raw state returned by <c>pad_scan</c>.</param>
+/// <returns>True if two rows have at least two columns in common.</returns>
+uint8_t keys_ghost(uint16_t sample);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYS_H_ */
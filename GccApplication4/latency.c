@@ -0,0 +1,101 @@
+/*
+ * latency.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */
+
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#include "board.h"
+#include "latency.h"
+
+static volatile latency_t latency_stats;
+static volatile uint16_t latency_begin;
+static volatile uint8_t latency_running;
+
+void latency_init(void)
+{
+	LATENCY_TIMER.CTRLA = TC_CLKSEL_OFF_gc;
+	LATENCY_TIMER.CTRLB = TC_WGMODE_NORMAL_gc;
+	LATENCY_TIMER.PER = 0xFFFF;
+	LATENCY_TIMER.CNT = 0;
+	LATENCY_TIMER.CTRLA = LATENCY_CLKSEL;
+	latency_clear();
+}
+
+/* The 16 bit read goes through the TEMP register of the timer, so it
+ * must not be interrupted by another read of the timer. */
+uint16_t latency_now(void)
+{
+	uint8_t sreg = SREG;
+	uint16_t now;
+	cli();
+	now = LATENCY_TIMER.CNT;
+	SREG = sreg;
+	return now;
+}
+
+uint8_t latency_start(uint16_t stamp)
+{
+	uint8_t sreg = SREG, started = 0;
+	cli();
+	if (latency_running) {
+		latency_stats.missed++;
+	}
+	else {
+		latency_begin = stamp;
+		latency_running = 1;
+		started = 1;
+	}
+	SREG = sreg;
+	return started;
+}
+
+void latency_stop(void)
+{
+	uint16_t latency;
+	if (!latency_running) return;
+	latency = latency_now()-latency_begin;
+	latency_stats.count++;
+	latency_stats.total += latency;
+	if (latency > latency_stats.maximum) latency_stats.maximum = latency;
+	latency_running = 0;
+}
+
+void latency_cancel(void)
+{
+	latency_running = 0;
+}
+
+void latency_read(latency_t *latency)
+{
+	uint8_t sreg = SREG;
+	cli();
+	*latency = *(latency_t*)&latency_stats;
+	SREG = sreg;
+}
+
+void latency_clear(void)
+{
+	uint8_t sreg = SREG;
+	cli();
+	latency_stats.count = 0;
+	latency_stats.maximum = 0;
+	latency_stats.total = 0;
+	latency_stats.missed = 0;
+	SREG = sreg;
+}
+
+void latency_print(void)
+{
+	latency_t latency;
+	latency_read(&latency);
+	printf_P(PSTR("# latency %u %lu %lu %u\n"), latency.count,
+		(latency.count) ? LATENCY_US(latency.total/latency.count) : 0UL,
+		LATENCY_US(latency.maximum), latency.missed);
+}
@@ -0,0 +1,99 @@
+/** \file latency.h
+*
+* \brief Measurement of the latency from a key event to the wire.
+*
+* The free running timer LATENCY_TIMER stamps every key event in the
+* scan interrupt that detects it. When the output of the event has been
+* queued, the writer starts a measurement with the stamp. The transmit
+* interrupt of the console stops it when it loads the last byte of the
+* output into the data register, i.e. one character time before the
+* byte has left the wire.
+*
+* The same measurement is compiled into the bare metal build (format
+* frame, see output.h) and the FreeRTOS build, and both print the
+* result with <c>latency_print</c>, so the two can be compared
+* directly. Only one measurement runs at a time; events written while
+* one is running are counted as missed.
+*
+* The timer runs with F_CPU/64 and wraps after 65536 ticks (131 ms at
+* 32 MHz, 2.1 s at 2 MHz). Longer latencies are not measured correctly.
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <stdint.h>
+
+#define LATENCY_TIMER TCD1
+#define LATENCY_PRESCALER 64
+#define LATENCY_CLKSEL TC_CLKSEL_DIV64_gc
+
+/// \def LATENCY_US(TICKS)
+/// <summary>Convert timer ticks to microseconds.</summary>
+#define LATENCY_US(TICKS) ((uint32_t)(TICKS) * LATENCY_PRESCALER / (F_CPU / 1000000UL))
+
+/// <summary>Latency statistics.</summary>
+typedef struct {
+	uint16_t count;    ///< Number of measured events.
+	uint16_t maximum;  ///< Maximum latency in ticks.
+	uint32_t total;    ///< Sum of the latencies in ticks.
+	uint16_t missed;   ///< Events not measured because a measurement was running.
+} latency_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Start the timer and clear the statistics.</summary>
+void latency_init(void);
+
+/// <summary>Read the timer.</summary>
+/// <remarks>Safe in interrupts and the main loop.</remarks>
+/// <returns>The time stamp in ticks.</returns>
+uint16_t latency_now(void);
+
+/// <summary>Start a measurement.</summary>
+/// <remarks>
+/// Called by the writer after the output of an event has been queued.
+/// </remarks>
+/// <param name="stamp">The time stamp of the event.</param>
+/// <returns>False if a measurement is already running.</returns>
+uint8_t latency_start(uint16_t stamp);
+
+/// <summary>Stop the measurement.</summary>
+/// <remarks>
+/// Called by the transmit interrupt when the last byte of the output
+/// has been loaded. Adds the latency to the statistics.
+/// </remarks>
+void latency_stop(void);
+
+/// <summary>Abandon the measurement.</summary>
+void latency_cancel(void);
+
+/// <summary>Read the statistics.</summary>
+/// <param name="latency">Receives a copy of the statistics.</param>
+void latency_read(latency_t *latency);
+
+/// <summary>Clear the statistics.</summary>
+void latency_clear(void);
+
+/// <summary>Print the statistics.</summary>
+/// <remarks>
+/// Prints the line "# latency count mean maximum missed" with the
+/// times in microseconds.
+/// </remarks>
+void latency_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LATENCY_H_ */
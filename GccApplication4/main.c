@@ -1,16 +1,60 @@
 
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include <util/delay.h>
+#include <avr/pgmspace.h>
 #include "board.h"
 #include "switch.h"
 #include "pad.h"
+#include "keys.h"
+#include "scan.h"
+#include "output.h"
+#include "shortcut.h"
+#include "shell.h"
+#include "stats.h"
 #include "usart.h"
 #include "console.h"
+#include "rtos.h"
+#include "trace.h"
+#include "latency.h"
 
+#ifndef USE_FREERTOS
+#define MAIN_LED_KEYS (PAD_KEY_STAR_bm | PAD_KEY_HASH_bm)
+
+static void main_stats(const scan_event_t *event)
+{
+	stats_press(event->pressed);
+}
+
+/* LED0 is lit while a key which starts a shortcut is held. */
+static void main_led(const scan_event_t *event)
+{
+	if (event->state & MAIN_LED_KEYS) LED_PORT.OUTCLR = LED0_PIN_bm;
+	else LED_PORT.OUTSET = LED0_PIN_bm;
+}
+
+/* The recognizer needs every key because other keys break a sequence,
+ * the report holds digits and modifiers, so only the LED filters. */
+static const pad_subscriber_t main_subscribers[] PROGMEM = {
+	{ PAD_KEYS_ALL, main_stats },
+	{ PAD_KEYS_ALL, output_event },
+	{ PAD_KEYS_ALL, shortcut_event },
+	{ PAD_KEYS_ALL, output_report },
+	{ MAIN_LED_KEYS, main_led },
+};
+
+#define MAIN_SUBSCRIBERS (sizeof(main_subscribers)/sizeof(main_subscribers[0]))
+#endif
 
 int main(void)
 {
+#ifndef USE_FREERTOS
+	pad_fault_t fault;
+#endif
+#if F_CPU == OSC_INTERNAL_32HZ
+	OSC_INIT_32MHZ();
+#endif
 
 	LED_PORT.DIR = LED0_PIN_bm;
  //
@@ -32,10 +76,35 @@ int main(void)
 	//
 	//USB_USART_MODULE.CTRLB = (USART_RXEN_bm | USART_TXEN_bm);
 	
-	usart_init();
-	console_init(usart_getc, usart_putc);
+	pad_init();
+	latency_init();
+	usart_init(&usart0);
+#ifdef USE_FREERTOS
+	rtos_start();
+#else
+	usart_buffer_init(&usart0);
+	usart_init(&usart1);
+	usart_buffer_init(&usart1);
+	usart_share_attach(&usart0,1);
+	usart_share_attach(&usart1,1);
+	console_init(usart_buffer_getc, usart_buffer_putc);
+	stats_init();
+	shortcut_init();
+	LED_PORT.OUTSET = LED0_PIN_bm;
+	pad_test(&fault);
+	scan_init(KEYS_DEFAULT_DEPTH);
+	scan_mask(fault.keys);
+#ifdef USE_TRACE
+	trace_init();
+#endif
+	PMIC.CTRL |= PMIC_LOLVLEN_bm;
+	sei();
+	if (fault.keys || fault.closed) shell_fault(&fault);
 
-	int keyPressed = 0;
+	scan_event_t event;
+	uint16_t errors = 0, count;
+	uint32_t time, flush = STATS_FLUSH_PERIOD*1000UL;
+	int c;
 	
 	/*
 				4	3	2	1
@@ -64,9 +133,33 @@ int main(void)
 			//USB_USART_MODULE.DATA = pad_scan();
 		//}
 		
-		printf("%04x", pad_scan());
-		_delay_ms(100);
+		TRACE_ENTER(TRACE_EVENTS);
+		while (scan_read(&event)) {
+			TRACE_ENTER(TRACE_DISPATCH);
+			pad_dispatch(main_subscribers,MAIN_SUBSCRIBERS,&event);
+			TRACE_LEAVE(TRACE_DISPATCH);
+		}
+		count = scan_errors();
+		for (;errors != count;errors++) stats_error();
+		TRACE_LEAVE(TRACE_EVENTS);
+		time = scan_time();
+		TRACE_ENTER(TRACE_OUTPUT);
+		output_task(time);
+		shortcut_task(time);
+		TRACE_LEAVE(TRACE_OUTPUT);
+		TRACE_ENTER(TRACE_SHELL);
+		while ((c = usart_buffer_receive(&usart0)) != USART_NO_DATA) shell_input(c);
+		TRACE_LEAVE(TRACE_SHELL);
+		TRACE_ENTER(TRACE_STATS);
+		if ((int32_t)(time-flush) >= 0) {
+			stats_flush();
+			flush = time+STATS_FLUSH_PERIOD*1000UL;
+		}
+		stats_task();
+		TRACE_LEAVE(TRACE_STATS);
+#ifdef USE_TRACE
+		trace_task();
+#endif
 	}
+#endif
 }
-
-
@@ -0,0 +1,100 @@
+/*
+ * output.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */ 
+
+#ifndef USE_FREERTOS
+
+#include <stdio.h>
+#include <avr/pgmspace.h>
+
+#include "usart.h"
+#include "frame.h"
+#include "report.h"
+#include "output.h"
+
+static const char output_off[] PROGMEM = "off";
+static const char output_hex[] PROGMEM = "hex";
+static const char output_frame[] PROGMEM = "frame";
+static PGM_P const output_names[OUTPUT_FORMATS] PROGMEM = { output_off, output_hex, output_frame };
+
+static uint8_t output_mode = OUTPUT_HEX;
+static uint32_t output_next;
+static report_t output_keys;
+static uint16_t output_every;
+static uint32_t output_due;
+
+uint8_t output_format(uint8_t format)
+{
+	if (format >= OUTPUT_FORMATS) return 0;
+	output_mode = format;
+	return 1;
+}
+
+uint8_t output_get_format(void)
+{
+	return output_mode;
+}
+
+PGM_P output_name(uint8_t format)
+{
+	return (PGM_P)pgm_read_ptr(&output_names[format]);
+}
+
+void output_event(const scan_event_t *event)
+{
+	uint8_t frame[FRAME_EVENT_SIZE+FRAME_OVERHEAD];
+	uint8_t length;
+	if (output_mode != OUTPUT_FRAME) return;
+	length = frame_event(frame,event->state,event->pressed,event->released,event->time);
+	if (usart_share_write(frame,length)) usart_share_latency(event->stamp);
+}
+
+void output_match(uint8_t id, uint16_t time)
+{
+	uint8_t frame[FRAME_MATCH_SIZE+FRAME_OVERHEAD];
+	uint8_t payload[FRAME_MATCH_SIZE];
+	if (output_mode != OUTPUT_FRAME) return;
+	payload[0] = id;
+	payload[1] = time & 0xFF;
+	payload[2] = time >> 8;
+	usart_share_write(frame,frame_encode(frame,FRAME_MATCH,payload,FRAME_MATCH_SIZE));
+}
+
+void output_report(const scan_event_t *event)
+{
+	report_update(&output_keys,event->state);
+}
+
+uint8_t output_report_period(uint16_t period)
+{
+	if (period && period < REPORT_PERIOD_MIN) return 0;
+	output_every = period;
+	output_due = scan_time();
+	return 1;
+}
+
+uint16_t output_get_report_period(void)
+{
+	return output_every;
+}
+
+void output_task(uint32_t time)
+{
+	uint8_t frame[FRAME_REPORT_SIZE+FRAME_OVERHEAD];
+	uint8_t payload[FRAME_REPORT_SIZE];
+	if (output_every && (int32_t)(time-output_due) >= 0) {
+		output_due += output_every;
+		if ((int32_t)(time-output_due) >= 0) output_due = time+output_every;
+		usart_share_write(frame,frame_encode(frame,FRAME_REPORT,payload,report_payload(&output_keys,payload)));
+	}
+	if (output_mode != OUTPUT_HEX || (int32_t)(time-output_next) < 0) return;
+	output_next = time+OUTPUT_HEX_PERIOD;
+	printf("%04x", scan_state());
+	usart_buffer_commit(USART_CONSOLE);
+}
+
+#endif /* USE_FREERTOS */
@@ -0,0 +1,97 @@
+/** \file output.h
+*
+* \brief Output of the key events.
+*
+* The key events are written to the USART in one of the following
+* formats:
+*
+* * OUTPUT_OFF: nothing is written.
+* * OUTPUT_HEX: the debounced state is printed with "%04x" every
+*   OUTPUT_HEX_PERIOD milliseconds.
+* * OUTPUT_FRAME: every key event is written as binary frame (see
+*   frame.h) into the shared buffer of the USARTs. It is transmitted by
+*   the console and, if mirroring is on, by usart1. Matches of chords
+*   and sequences (see shortcut.h) are written as FRAME_MATCH frames.
+*   The latency of the event frames on the console is measured, see
+*   latency.h.
+*
+* Periodic reports of the pressed keys (see report.h) are independent
+* of the format and written as FRAME_REPORT frames into the shared
+* buffer, too.
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef OUTPUT_H_
+#define OUTPUT_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "scan.h"
+
+#define OUTPUT_OFF 0
+#define OUTPUT_HEX 1
+#define OUTPUT_FRAME 2
+#define OUTPUT_FORMATS 3
+
+#define OUTPUT_HEX_PERIOD 100
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Change the output format.</summary>
+/// <param name="format">The new format.</param>
+/// <returns>False if the format is invalid.</returns>
+uint8_t output_format(uint8_t format);
+
+/// <summary>Read the output format.</summary>
+/// <returns>The output format.</returns>
+uint8_t output_get_format(void);
+
+/// <summary>Get the name of a format.</summary>
+/// <param name="format">The format.</param>
+/// <returns>The name stored in PROGMEM.</returns>
+PGM_P output_name(uint8_t format);
+
+/// <summary>Write a key event.</summary>
+/// <param name="event">The key event.</param>
+void output_event(const scan_event_t *event);
+
+/// <summary>Write a match of a chord or sequence.</summary>
+/// <param name="id">The identifier of the pattern.</param>
+/// <param name="time">The time in milliseconds.</param>
+void output_match(uint8_t id, uint16_t time);
+
+/// <summary>Update the report of the pressed keys.</summary>
+/// <param name="event">The key event.</param>
+void output_report(const scan_event_t *event);
+
+/// <summary>Change the period of the reports.</summary>
+/// <param name="period">The period in milliseconds, 0 switches reports off.</param>
+/// <returns>False if the period is below REPORT_PERIOD_MIN.</returns>
+uint8_t output_report_period(uint16_t period);
+
+/// <summary>Read the period of the reports.</summary>
+/// <returns>The period in milliseconds, 0 if reports are off.</returns>
+uint16_t output_get_report_period(void);
+
+/// <summary>Write periodic output.</summary>
+/// <remarks>
+/// Writes the hex output and the reports when they are due. Must be
+/// called periodically from the main loop.
+/// </remarks>
+/// <param name="time">The time in milliseconds.</param>
+void output_task(uint32_t time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OUTPUT_H_ */
@@ -2,6 +2,7 @@
  * pad.c
  *
  * Created: 18.01.2018 21:04:30
+ * Modified: 2026-10-19
  *  Author: Julian
  */ 
 
@@ -31,31 +32,152 @@
 	
 	*/
 
-initPad(){
+void pad_init(void)
+{
+	GPIO_VPORT_INIT();
 	//lines
-	PORTD.DIR = (PIN4_bm | PIN5_bm | PIN6_bm | PIN7_bm);
+	PAD_PORT.OUTCLR = PAD_LINES_gm;
+	PAD_PORT.DIRSET = PAD_LINES_gm;
 	//rows
-	PORTD.DIR |= (PIN3_bm | PIN2_bm | PIN1_bm | PIN0_bm);
+	PAD_PORT.DIRCLR = PAD_SENSE_gm;
+	PORTCFG.MPCMASK = PAD_SENSE_gm;
+	PAD_PORT.PIN0CTRL = PORT_OPC_PULLDOWN_gc;
 }
 
-uint16_t pad_scan(){
+uint16_t pad_scan(void)
+{
 	uint16_t buttonstates = 0x00;
 	
-	PORTD.OUT = PIN4_bm;
-	buttonstates |= (PORTD.IN);
+	PAD_VPORT.OUT = PIN4_bm;
+	_delay_us(1);
+	buttonstates |= (PAD_VPORT.IN & PAD_SENSE_gm);
 	
-	PORTD.OUT = PIN5_bm;
+	PAD_VPORT.OUT = PIN5_bm;
+	_delay_us(1);
 	buttonstates = (buttonstates << 4);
-	buttonstates |= (PORTD.IN);
+	buttonstates |= (PAD_VPORT.IN & PAD_SENSE_gm);
 	
-	PORTD.OUT = PIN6_bm;
-	buttonstates = (buttonstates << 8);
-	buttonstates |= (PORTD.IN);
+	PAD_VPORT.OUT = PIN6_bm;
+	_delay_us(1);
+	buttonstates = (buttonstates << 4);
+	buttonstates |= (PAD_VPORT.IN & PAD_SENSE_gm);
 	
-	PORTD.OUT = PIN7_bm;
-	buttonstates = (buttonstates << 12);
-	buttonstates |= (PORTD.IN);
+	PAD_VPORT.OUT = PIN7_bm;
+	_delay_us(1);
+	buttonstates = (buttonstates << 4);
+	buttonstates |= (PAD_VPORT.IN & PAD_SENSE_gm);
 	
-	PORTD.OUT = 0x00;
+	PAD_VPORT.OUT = 0x00;
 	return buttonstates;
-}
\ No newline at end of file
+}
+
+uint16_t pad_pressed(uint16_t current, uint16_t previous)
+{
+	return current & ~previous;
+}
+
+uint16_t pad_released(uint16_t current, uint16_t previous)
+{
+	return ~current & previous;
+}
+
+#define PAD_PINS_gm (PAD_LINES_gm | PAD_SENSE_gm)
+
+/* Bit of the key at a drive line and a sense line in the state. */
+#define PAD_KEY_BIT(LINE,SENSE) (((PAD_ROWS-1-(LINE))*PAD_COLS)+(SENSE))
+
+static void pad_pull(uint8_t pins, uint8_t opc)
+{
+	if (!pins) return;
+	PORTCFG.MPCMASK = pins;
+	PAD_PORT.PIN0CTRL = opc;
+}
+
+/* Drives the given pins high, pulls all other pins with opc and reads
+ * the pins after they have settled. */
+static uint8_t pad_probe(uint8_t drive, uint8_t opc)
+{
+	PAD_PORT.OUTSET = drive;
+	PAD_PORT.DIRSET = drive;
+	PAD_PORT.DIRCLR = PAD_PINS_gm & ~drive;
+	pad_pull(PAD_PINS_gm & ~drive,opc);
+	_delay_us(PAD_SETTLE_US);
+	return PAD_VPORT.IN & PAD_PINS_gm & ~drive;
+}
+
+/* One pass of the self-test, the faulty keys are not set. */
+static void pad_test_run(pad_fault_t *fault)
+{
+	uint8_t sense[PAD_ROWS], lines[PAD_ROWS], follow[PAD_COLS];
+	uint8_t bad, i, j, k, pins;
+	fault->high = pad_probe(0,PORT_OPC_PULLDOWN_gc);
+	fault->low = ~pad_probe(0,PORT_OPC_PULLUP_gc) & PAD_PINS_gm;
+	bad = fault->high | fault->low;
+	for (i=0;i<PAD_ROWS;i++) {
+		pins = (PAD_LINE_bm(i) & bad) ? 0 : pad_probe(PAD_LINE_bm(i),PORT_OPC_PULLDOWN_gc) & ~bad;
+		sense[i] = pins & PAD_SENSE_gm;
+		lines[i] = pins & PAD_LINES_gm;
+	}
+	for (i=0;i<PAD_COLS;i++) {
+		follow[i] = ((1<<i) & bad) ? 0 : pad_probe(1<<i,PORT_OPC_PULLDOWN_gc) & PAD_SENSE_gm & ~bad;
+	}
+	PAD_PORT.OUTCLR = PAD_PINS_gm;
+	PAD_PORT.DIRCLR = PAD_SENSE_gm;
+	PAD_PORT.DIRSET = PAD_LINES_gm;
+	pad_pull(PAD_LINES_gm,PORT_OPC_TOTEM_gc);
+	pad_pull(PAD_SENSE_gm,PORT_OPC_PULLDOWN_gc);
+
+	fault->shorted = 0;
+	fault->closed = 0;
+	for (i=0;i<PAD_ROWS;i++) {
+		for (j=0;j<PAD_COLS;j++) {
+			if (sense[i] & (1<<j)) fault->closed |= 1U << PAD_KEY_BIT(i,j);
+		}
+		/* Two drive lines are connected by keys in a common column. */
+		for (j=0;j<PAD_ROWS;j++) {
+			if ((lines[i] & PAD_LINE_bm(j)) && !(sense[i] & sense[j])) {
+				fault->shorted |= PAD_LINE_bm(i) | PAD_LINE_bm(j);
+			}
+		}
+	}
+	/* Two sense lines are connected by keys on a common drive line. */
+	for (i=0;i<PAD_COLS;i++) {
+		for (j=0;j<PAD_COLS;j++) {
+			if (!(follow[i] & (1<<j))) continue;
+			for (k=0;k<PAD_ROWS;k++) {
+				if ((sense[k] & (1<<i)) && (sense[k] & (1<<j))) break;
+			}
+			if (k == PAD_ROWS) fault->shorted |= (1<<i) | (1<<j);
+		}
+	}
+}
+
+/* A fault must be found in every pass. Shorts of pins with a closed
+ * key are not masked because current through several closed keys may
+ * make a pin follow that the keys do not explain. */
+uint8_t pad_test(pad_fault_t *fault)
+{
+	pad_fault_t run;
+	uint8_t bad, pins = 0, i, j;
+	pad_test_run(fault);
+	for (i=1;i<PAD_TEST_RUNS;i++) {
+		pad_test_run(&run);
+		fault->high &= run.high;
+		fault->low &= run.low;
+		fault->shorted &= run.shorted;
+		fault->closed &= run.closed;
+	}
+	for (i=0;i<PAD_ROWS;i++) {
+		for (j=0;j<PAD_COLS;j++) {
+			if (fault->closed & (1U << PAD_KEY_BIT(i,j))) pins |= PAD_LINE_bm(i) | (1<<j);
+		}
+	}
+	bad = fault->high | fault->low | (fault->shorted & ~pins);
+	fault->keys = 0;
+	for (i=0;i<PAD_ROWS;i++) {
+		for (j=0;j<PAD_COLS;j++) {
+			if (bad & (PAD_LINE_bm(i) | (1<<j))) fault->keys |= 1U << PAD_KEY_BIT(i,j);
+		}
+	}
+	return !(fault->high | fault->low | fault->shorted) && !fault->closed;
+}
@@ -5,19 +5,96 @@
 * This file defines the pin mapping for the 74HC237 3-to-8 line decoder with address latches.
 *
 * \author    Wolfgang Neff
-* \version   1.0
-* \date      2016-07-12
+* \version   1.1
+* \date      2026-10-19
 *
 * \par History
-*      Created: 2016-07-12
+*      Created: 2016-07-12 \n
+*      Modified: 2026-10-19
 */
 
 #ifndef PAD_H_
 #define PAD_H_
 
+#include <stdint.h>
+#include "scan.h"
+
 #define PAD_COLS 4
 #define PAD_ROWS 4
 
+/// \def PAD_KEY_NAMES
+/// <summary>Names of the keys indexed by their bit in the state.</summary>
+/// <remarks>
+/// Each nibble of the state holds one row; the top row 1 2 3 A is
+/// in the highest nibble.
+/// </remarks>
+#define PAD_KEY_NAMES "*0#D789C456B123A"
+
+/****** Keys ******/
+#define PAD_KEY_STAR_bm 0x0001
+#define PAD_KEY_0_bm 0x0002
+#define PAD_KEY_HASH_bm 0x0004
+#define PAD_KEY_D_bm 0x0008
+#define PAD_KEY_7_bm 0x0010
+#define PAD_KEY_8_bm 0x0020
+#define PAD_KEY_9_bm 0x0040
+#define PAD_KEY_C_bm 0x0080
+#define PAD_KEY_4_bm 0x0100
+#define PAD_KEY_5_bm 0x0200
+#define PAD_KEY_6_bm 0x0400
+#define PAD_KEY_B_bm 0x0800
+#define PAD_KEY_1_bm 0x1000
+#define PAD_KEY_2_bm 0x2000
+#define PAD_KEY_3_bm 0x4000
+#define PAD_KEY_A_bm 0x8000
+
+#define PAD_KEYS_ALL 0xFFFF
+
+/****** Pins ******/
+#define PAD_PORT GPIO_LOW_PORT
+#define PAD_VPORT GPIO_LOW_VPORT
+#define PAD_LINES_gm 0xF0
+#define PAD_SENSE_gm 0x0F
+
+/// \def PAD_LINE_bm(LINE)
+/// <summary>Bit mask of a drive line.</summary>
+/// <remarks>
+/// Line 0 drives the top row. The sense lines of line n are stored in
+/// nibble 3-n of the state.
+/// </remarks>
+#define PAD_LINE_bm(LINE) (0x10 << (LINE))
+
+/// \def PAD_SETTLE_US
+/// <summary>Settling time of the pins in the self-test in microseconds.</summary>
+#ifndef PAD_SETTLE_US
+#define PAD_SETTLE_US 10
+#endif
+
+/// \def PAD_TEST_RUNS
+/// <summary>Number of passes of the self-test.</summary>
+#ifndef PAD_TEST_RUNS
+#define PAD_TEST_RUNS 3
+#endif
+
+/// <summary>Result of the self-test.</summary>
+/// <remarks>
+/// The pin masks use the bits of the port: sense lines in bits 0 to 3,
+/// drive lines in bits 4 to 7.
+/// </remarks>
+typedef struct {
+	uint8_t high;     ///< Pins stuck at the high level.
+	uint8_t low;      ///< Pins stuck at the low level.
+	uint8_t shorted;  ///< Pins shorted with another pin of the matrix.
+	uint16_t closed;  ///< Keys closed during the test, a warning.
+	uint16_t keys;    ///< Faulty keys to be masked, see pad_test.
+} pad_fault_t;
+
+/// <summary>Subscriber of key events.</summary>
+typedef struct {
+	uint16_t mask;                               ///< Keys of interest.
+	void (*handler)(const scan_event_t *event);  ///< Called for events of these keys.
+} pad_subscriber_t;
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -50,6 +127,48 @@ uint16_t pad_pressed(uint16_t current, uint16_t previous);
 /// <returns>Keys newly released since the last scan.</returns>
 uint16_t pad_released(uint16_t current, uint16_t previous);
 
+/// <summary>Test the matrix.</summary>
+/// <remarks>
+/// First all pins are read with pull-downs and with pull-ups to find
+/// pins stuck at a level. Then each drive line and each sense line is
+/// driven high on its own while all other pins are pulled down. A pin
+/// that follows is either connected through closed keys or shorted.
+/// Closed keys are found from the sense lines of each drive line. A
+/// connection that closed keys do not explain is reported as a short.
+///
+/// The test is run PAD_TEST_RUNS times and a fault or closed key is
+/// only reported if it is found every time. A closed key, e.g. one
+/// held during boot, is a warning and is not masked. It cannot be told
+/// from a stuck contact until it has been released, so the test should
+/// be repeated then. Shorts of pins with a closed key are reported but
+/// not masked either, because current through two or more closed keys
+/// can make pins follow that the keys do not explain. Only the keys on
+/// pins stuck at a level or shorted without a closed key are faulty.
+///
+/// The test takes 10*PAD_TEST_RUNS settling times of PAD_SETTLE_US,
+/// about 0.3 ms, and leaves the pins configured as after
+/// <c>pad_init</c>. Scanning must be paused while it runs.
+/// </remarks>
+/// <param name="fault">Receives the result.</param>
+/// <returns>True if no fault and no closed key has been found.</returns>
+uint8_t pad_test(pad_fault_t *fault);
+
+/// <summary>Dispatch a key event.</summary>
+/// <remarks>
+/// Calls the handler of every subscriber whose mask contains a pressed
+/// or released key of the event, in the order of the table. The table
+/// is defined at compile time in PROGMEM, so there is no registration
+/// at runtime. The handlers get a pointer to the event and must not
+/// change it. The time of a dispatch is bounded by the length of the
+/// table and the handlers. It is implemented in dispatch.c without
+/// hardware access, so padtool measures it on the host.
+/// </remarks>
+/// <param name="table">The subscribers in PROGMEM.</param>
+/// <param name="count">The number of subscribers.</param>
+/// <param name="event">The key event.</param>
+/// <returns>The number of handlers called.</returns>
+uint8_t pad_dispatch(const pad_subscriber_t *table, uint8_t count, const scan_event_t *event);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,50 @@
+/*
+ * rate.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */ 
+
+#include "rate.h"
+
+void rate_init(rate_t *rate, uint16_t fast, uint16_t slow, uint16_t quiet)
+{
+	uint8_t i;
+	for (i=0;i<2;i++) {
+		rate->time[i] = 0;
+		rate->rest[i] = 0;
+		rate->scans[i] = 0;
+	}
+	rate->current = RATE_SLOW;
+	rate->idle = 0;
+	rate_config(rate,fast,slow,quiet);
+}
+
+void rate_config(rate_t *rate, uint16_t fast, uint16_t slow, uint16_t quiet)
+{
+	rate->period[RATE_FAST] = fast;
+	rate->period[RATE_SLOW] = slow;
+	rate->quiet = quiet;
+}
+
+uint16_t rate_update(rate_t *rate, uint8_t active)
+{
+	uint8_t current = rate->current;
+	uint16_t period = rate->period[current];
+	rate->scans[current]++;
+	rate->rest[current] += period;
+	while (rate->rest[current] >= 1000) {
+		rate->rest[current] -= 1000;
+		rate->time[current]++;
+	}
+	if (active) {
+		rate->idle = 0;
+		rate->current = RATE_FAST;
+	}
+	else if (current == RATE_FAST) {
+		rate->idle += period;
+		if (rate->idle >= rate->quiet*1000UL) rate->current = RATE_SLOW;
+	}
+	return rate->period[rate->current];
+}
@@ -0,0 +1,78 @@
+/** \file rate.h
+*
+* \brief Adaptive scan rate.
+*
+* The keypad is scanned with the fast period as soon as a key is
+* pressed or the debouncer has a pending change. After the keypad has
+* been quiet for the given time the scanner falls back to the slow
+* period. The quiet time is the hysteresis: a short pause while typing
+* does not slow down the scanner.
+*
+* The module counts the time and the number of scans at each rate.
+* It depends on nothing but <c>stdint.h</c> and is also compiled into
+* the host tools.
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef RATE_H_
+#define RATE_H_
+
+#include <stdint.h>
+
+#define RATE_SLOW 0
+#define RATE_FAST 1
+
+/// <summary>State of the adaptive scan rate.</summary>
+typedef struct {
+	uint16_t period[2];  ///< Scan period in microseconds at each rate.
+	uint16_t quiet;      ///< Quiet time in milliseconds.
+	uint32_t idle;       ///< Time since the last activity in microseconds.
+	uint8_t current;     ///< The current rate.
+	uint32_t time[2];    ///< Milliseconds spent at each rate.
+	uint16_t rest[2];    ///< Microseconds not yet counted in time.
+	uint32_t scans[2];   ///< Scans at each rate.
+} rate_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Initialize the adaptive scan rate.</summary>
+/// <remarks>
+/// Starts with the slow period and clears the counters. Equal
+/// periods give a fixed scan rate.
+/// </remarks>
+/// <param name="rate">The adaptive scan rate.</param>
+/// <param name="fast">The fast period in microseconds.</param>
+/// <param name="slow">The slow period in microseconds.</param>
+/// <param name="quiet">The quiet time in milliseconds.</param>
+void rate_init(rate_t *rate, uint16_t fast, uint16_t slow, uint16_t quiet);
+
+/// <summary>Change the parameters.</summary>
+/// <remarks>
+/// Keeps the counters and the current rate.
+/// </remarks>
+/// <param name="rate">The adaptive scan rate.</param>
+/// <param name="fast">The fast period in microseconds.</param>
+/// <param name="slow">The slow period in microseconds.</param>
+/// <param name="quiet">The quiet time in milliseconds.</param>
+void rate_config(rate_t *rate, uint16_t fast, uint16_t slow, uint16_t quiet);
+
+/// <summary>Account a scan and select the next period.</summary>
+/// <param name="rate">The adaptive scan rate.</param>
+/// <param name="active">True if a key is pressed or a change is pending.</param>
+/// <returns>The period until the next scan in microseconds.</returns>
+uint16_t rate_update(rate_t *rate, uint8_t active);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RATE_H_ */
@@ -0,0 +1,117 @@
+/*
+ * report.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */
+
+#include "pad.h"
+#include "report.h"
+
+#define REPORT_DIGITS_gm (PAD_KEY_0_bm | PAD_KEY_1_bm | PAD_KEY_2_bm | PAD_KEY_3_bm | PAD_KEY_4_bm | \
+	PAD_KEY_5_bm | PAD_KEY_6_bm | PAD_KEY_7_bm | PAD_KEY_8_bm | PAD_KEY_9_bm)
+
+/* The code of a digit is its name. */
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+static const char report_codes[] PROGMEM = PAD_KEY_NAMES;
+#define REPORT_CODE(KEY) pgm_read_byte(&report_codes[KEY])
+#else
+static const char report_codes[] = PAD_KEY_NAMES;
+#define REPORT_CODE(KEY) ((uint8_t)report_codes[KEY])
+#endif
+
+static void report_add(report_t *report, uint8_t code)
+{
+	uint8_t i;
+	for (i=0;i<REPORT_KEYS;i++) {
+		if (report->keys[i] == 0) {
+			report->keys[i] = code;
+			return;
+		}
+	}
+}
+
+/* Keeps the order of pressing. */
+static void report_remove(report_t *report, uint8_t code)
+{
+	uint8_t i;
+	for (i=0;i<REPORT_KEYS && report->keys[i] != code;i++);
+	if (i == REPORT_KEYS) return;
+	for (;i<REPORT_KEYS-1;i++) report->keys[i] = report->keys[i+1];
+	report->keys[REPORT_KEYS-1] = 0;
+}
+
+static void report_rebuild(report_t *report)
+{
+	uint16_t keys = report->state & REPORT_DIGITS_gm;
+	uint8_t i;
+	for (i=0;i<REPORT_KEYS;i++) report->keys[i] = 0;
+	while (keys) {
+		report_add(report,REPORT_CODE(__builtin_ctz(keys)));
+		keys &= keys-1;
+	}
+	report->overflow = 0;
+}
+
+static uint8_t report_modifiers(uint16_t state)
+{
+	uint8_t modifiers = 0;
+	if (state & PAD_KEY_STAR_bm) modifiers |= REPORT_MOD_STAR;
+	if (state & PAD_KEY_HASH_bm) modifiers |= REPORT_MOD_HASH;
+	if (state & PAD_KEY_A_bm) modifiers |= REPORT_MOD_A;
+	if (state & PAD_KEY_B_bm) modifiers |= REPORT_MOD_B;
+	if (state & PAD_KEY_C_bm) modifiers |= REPORT_MOD_C;
+	if (state & PAD_KEY_D_bm) modifiers |= REPORT_MOD_D;
+	return modifiers;
+}
+
+void report_init(report_t *report)
+{
+	uint8_t i;
+	for (i=0;i<REPORT_KEYS;i++) report->keys[i] = 0;
+	report->count = 0;
+	report->overflow = 0;
+	report->state = 0;
+	report->sequence = 0;
+}
+
+/* The changes are taken from the state, so a lost event cannot leave
+ * stale codes behind. */
+void report_update(report_t *report, uint16_t state)
+{
+	uint16_t changed = (state ^ report->state) & REPORT_DIGITS_gm;
+	uint16_t released = changed & report->state;
+	uint16_t pressed = changed & state;
+	report->state = state;
+	report->count = __builtin_popcount(state & REPORT_DIGITS_gm);
+	if (report->count > REPORT_KEYS) {
+		report->overflow = 1;
+		return;
+	}
+	/* Digits which did not fit are only known from the state. */
+	if (report->overflow) {
+		report_rebuild(report);
+		return;
+	}
+	while (released) {
+		report_remove(report,REPORT_CODE(__builtin_ctz(released)));
+		released &= released-1;
+	}
+	while (pressed) {
+		report_add(report,REPORT_CODE(__builtin_ctz(pressed)));
+		pressed &= pressed-1;
+	}
+}
+
+uint8_t report_payload(report_t *report, uint8_t *payload)
+{
+	uint8_t i;
+	payload[0] = report->sequence++;
+	payload[1] = report_modifiers(report->state);
+	for (i=0;i<REPORT_KEYS;i++) {
+		payload[2+i] = (report->count > REPORT_KEYS) ? REPORT_ROLLOVER : report->keys[i];
+	}
+	return FRAME_REPORT_SIZE;
+}
@@ -0,0 +1,88 @@
+/** \file report.h
+*
+* \brief Periodic reports of the pressed keys.
+*
+* Besides the change events, the state of the keypad can be reported
+* with a fixed rate, similar to the input report of a HID keyboard.
+* Every report is a FRAME_REPORT frame with a payload of
+* FRAME_REPORT_SIZE bytes:
+*
+* | Byte | Content                                                  |
+* |------|----------------------------------------------------------|
+* | 0    | Sequence counter, incremented with every report.         |
+* | 1    | Modifiers: REPORT_MOD_STAR, REPORT_MOD_HASH and          |
+* |      | REPORT_MOD_A to REPORT_MOD_D.                            |
+* | 2..  | REPORT_KEYS key codes in the order of pressing, 0 if     |
+* |      | unused. The code of a digit is its ASCII character. If   |
+* |      | more digits are pressed, all codes are REPORT_ROLLOVER.  |
+*
+* The report is updated with the debounced state of every key event
+* and only touches the keys which changed since the last update, so it
+* stays correct if events are lost. Only when the digits pressed drop
+* back to REPORT_KEYS after a rollover are the codes rebuilt from the
+* state. The module does not depend on the hardware and is also built
+* into padtool. The application writes the reports with
+* <c>output_report_period</c> (see output.h).
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef REPORT_H_
+#define REPORT_H_
+
+#include <stdint.h>
+#include "frame.h"
+
+#define REPORT_KEYS (FRAME_REPORT_SIZE-2)
+#define REPORT_ROLLOVER 0x01
+#define REPORT_PERIOD_MIN 4
+
+#define REPORT_MOD_STAR 0x01
+#define REPORT_MOD_HASH 0x02
+#define REPORT_MOD_A    0x04
+#define REPORT_MOD_B    0x08
+#define REPORT_MOD_C    0x10
+#define REPORT_MOD_D    0x20
+
+/// <summary>State of a report.</summary>
+typedef struct {
+	uint8_t keys[REPORT_KEYS];  ///< Codes in the order of pressing, 0 if unused.
+	uint8_t count;              ///< Number of digits pressed.
+	uint8_t overflow;           ///< More than REPORT_KEYS digits were pressed.
+	uint16_t state;             ///< The debounced state of the last update.
+	uint8_t sequence;           ///< Sequence counter of the next report.
+} report_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Initialize a report.</summary>
+/// <param name="report">The report.</param>
+void report_init(report_t *report);
+
+/// <summary>Update a report.</summary>
+/// <param name="report">The report.</param>
+/// <param name="state">The debounced state of the keys.</param>
+void report_update(report_t *report, uint16_t state);
+
+/// <summary>Build the payload of a FRAME_REPORT frame.</summary>
+/// <remarks>
+/// Increments the sequence counter.
+/// </remarks>
+/// <param name="report">The report.</param>
+/// <param name="payload">Receives FRAME_REPORT_SIZE bytes.</param>
+/// <returns>FRAME_REPORT_SIZE.</returns>
+uint8_t report_payload(report_t *report, uint8_t *payload);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REPORT_H_ */
@@ -0,0 +1,104 @@
+/*
+ * rtos.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */ 
+
+#ifdef USE_FREERTOS
+
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#include "board.h"
+#include "pad.h"
+#include "keys.h"
+#include "usart.h"
+#include "console.h"
+#include "timer.h"
+#include "latency.h"
+#include "rtos.h"
+
+typedef struct {
+	uint16_t state;
+	uint16_t stamp;
+} rtos_event_t;
+
+static StaticQueue_t rtos_queue_buffer;
+static uint8_t rtos_queue_storage[RTOS_QUEUE_LENGTH*sizeof(rtos_event_t)];
+static QueueHandle_t rtos_queue;
+
+static StaticTask_t rtos_print_tcb;
+static StackType_t rtos_print_stack[RTOS_PRINT_STACK_SIZE];
+
+static StaticTask_t rtos_idle_tcb;
+static StackType_t rtos_idle_stack[configMINIMAL_STACK_SIZE];
+
+static keys_t rtos_keys;
+static uint16_t rtos_previous;
+static volatile uint16_t rtos_dropped;
+
+/* Called as the last statement of the TCC0 interrupt, so the yield is
+ * the last statement of the interrupt, too. */
+static void rtos_scan(void)
+{
+	BaseType_t woken = pdFALSE;
+	rtos_event_t event;
+	event.state = keys_update(&rtos_keys,pad_scan());
+	if (event.state == rtos_previous) return;
+	event.stamp = latency_now();
+	if (xQueueSendFromISR(rtos_queue,&event,&woken) == pdTRUE) {
+		rtos_previous = event.state;
+	}
+	else {
+		rtos_dropped++;
+	}
+	portYIELD_FROM_ISR(woken);
+}
+
+static void rtos_print(void *parameters)
+{
+	rtos_event_t event;
+	TickType_t last = xTaskGetTickCount();
+	for (;;) {
+		if (xQueueReceive(rtos_queue,&event,pdMS_TO_TICKS(RTOS_LATENCY_PERIOD)) == pdTRUE) {
+			printf("%04x", event.state);
+			usart_stream_latency(event.stamp);
+		}
+		if ((TickType_t)(xTaskGetTickCount()-last) >= pdMS_TO_TICKS(RTOS_LATENCY_PERIOD)) {
+			last += pdMS_TO_TICKS(RTOS_LATENCY_PERIOD);
+			putchar('\n');
+			latency_print();
+			printf_P(PSTR("# dropped %u\n"), rtos_dropped);
+		}
+	}
+}
+
+void rtos_start(void)
+{
+	keys_init(&rtos_keys,KEYS_DEFAULT_DEPTH);
+	rtos_queue = xQueueCreateStatic(RTOS_QUEUE_LENGTH,sizeof(rtos_event_t),rtos_queue_storage,&rtos_queue_buffer);
+	usart_stream_init();
+	console_init(usart_stream_getc, usart_stream_putc);
+	xTaskCreateStatic(rtos_print,"print",RTOS_PRINT_STACK_SIZE,NULL,RTOS_PRINT_PRIORITY,rtos_print_stack,&rtos_print_tcb);
+	timer_init(RTOS_SCAN_PERIOD, rtos_scan);
+	PMIC.CTRL |= PMIC_LOLVLEN_bm;
+	vTaskStartScheduler();
+	for (;;);
+}
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *size)
+{
+	*tcb = &rtos_idle_tcb;
+	*stack = rtos_idle_stack;
+	*size = configMINIMAL_STACK_SIZE;
+}
+
+#endif /* USE_FREERTOS */
@@ -0,0 +1,60 @@
+/** \file rtos.h
+*
+* \brief FreeRTOS port of the keypad application.
+*
+* This module is only compiled if USE_FREERTOS is defined (build
+* configuration FreeRTOS). The keypad is scanned and debounced in the
+* TCC0 interrupt which posts key events into a queue. A low priority
+* task formats the events with printf and writes them into the USART
+* transmit stream buffer. The latency from the scan to the last byte
+* of the event on the wire is measured with latency.h like in the bare
+* metal build and printed every RTOS_LATENCY_PERIOD milliseconds with
+* the number of events which did not fit into the queue:
+*
+*     # latency count mean maximum missed
+*     # dropped count
+*
+* The FreeRTOS kernel is not part of this project. The build
+* configuration expects its sources in $(FREERTOS_DIR) together
+* with an ATxmega port that uses TCC1 as tick generator and provides
+* portYIELD_FROM_ISR. Interrupts only switch the context through
+* portYIELD_FROM_ISR as their last statement, so the level of the
+* interrupt is left before the switch.
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef RTOS_H_
+#define RTOS_H_
+
+#include <stdint.h>
+
+#define RTOS_SCAN_PERIOD 2000
+#define RTOS_QUEUE_LENGTH 8
+#define RTOS_PRINT_STACK_SIZE 256
+#define RTOS_PRINT_PRIORITY (tskIDLE_PRIORITY + 1)
+#define RTOS_LATENCY_PERIOD 10000
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Start the FreeRTOS application.</summary>
+/// <remarks>
+/// Creates the queue and tasks, starts the scan interrupt and the
+/// scheduler. The USART and the keypad must be initialized before.
+/// This function does not return.
+/// </remarks>
+void rtos_start(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RTOS_H_ */
@@ -0,0 +1,176 @@
+/*
+ * scan.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */ 
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "board.h"
+#include "pad.h"
+#include "keys.h"
+#include "timer.h"
+#include "scan.h"
+#include "trace.h"
+#include "latency.h"
+
+#define SCAN_QUEUE_MASK (SCAN_QUEUE_SIZE-1)
+
+#if SCAN_PERIOD_MAX * (F_CPU / 1000UL) / (TIMER_PRESCALER * 1000UL) > 65536UL
+#error "SCAN_PERIOD_MAX does not fit into the timer period"
+#endif
+
+static keys_t scan_keys;
+static rate_t scan_adapt;
+static scan_event_t scan_queue[SCAN_QUEUE_SIZE];
+static volatile uint8_t scan_head, scan_tail;
+static volatile uint16_t scan_us;
+static volatile uint32_t scan_ms;
+static volatile uint16_t scan_lost;
+static volatile uint16_t scan_masked;
+static uint16_t scan_interval;
+
+static void scan_tick(void)
+{
+	uint16_t previous = scan_keys.state;
+	uint16_t sample, state, period;
+	uint8_t head;
+	scan_us += scan_interval;
+	while (scan_us >= 1000) {
+		scan_us -= 1000;
+		scan_ms++;
+	}
+	TRACE_ENTER(TRACE_SCAN);
+	sample = pad_scan() & ~scan_masked;
+	TRACE_LEAVE(TRACE_SCAN);
+	state = keys_update(&scan_keys,sample);
+	period = rate_update(&scan_adapt,sample || keys_pending(&scan_keys));
+	if (period != scan_interval) {
+		timer_next(period);
+		scan_interval = period;
+	}
+	if (state == previous) return;
+	head = (scan_head+1) & SCAN_QUEUE_MASK;
+	if (head == scan_tail) {
+		scan_lost++;
+		return;
+	}
+	scan_queue[scan_head].state = state;
+	scan_queue[scan_head].pressed = pad_pressed(state,previous);
+	scan_queue[scan_head].released = pad_released(state,previous);
+	scan_queue[scan_head].time = scan_ms;
+	scan_queue[scan_head].stamp = latency_now();
+	scan_head = head;
+}
+
+void scan_init(uint8_t depth)
+{
+	keys_init(&scan_keys,depth);
+	rate_init(&scan_adapt,SCAN_FAST_PERIOD,SCAN_SLOW_PERIOD,SCAN_QUIET_TIME);
+	scan_interval = SCAN_SLOW_PERIOD;
+	timer_init(SCAN_SLOW_PERIOD,scan_tick);
+}
+
+uint8_t scan_period(uint16_t period)
+{
+	return scan_rate(period,period,scan_adapt.quiet);
+}
+
+uint8_t scan_rate(uint16_t fast, uint16_t slow, uint16_t quiet)
+{
+	if (fast < SCAN_PERIOD_MIN || slow > SCAN_PERIOD_MAX || fast > slow) return 0;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		rate_config(&scan_adapt,fast,slow,quiet);
+	}
+	return 1;
+}
+
+void scan_get_rate(rate_t *rate)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		*rate = scan_adapt;
+	}
+}
+
+uint16_t scan_get_period(void)
+{
+	uint16_t period;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		period = scan_interval;
+	}
+	return period;
+}
+
+uint8_t scan_depth(uint8_t depth)
+{
+	if (depth < KEYS_DEPTH_MIN || depth > KEYS_DEPTH_MAX) return 0;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		keys_depth(&scan_keys,depth);
+	}
+	return 1;
+}
+
+uint8_t scan_get_depth(void)
+{
+	return scan_keys.depth;
+}
+
+void scan_pause(uint8_t pause)
+{
+	timer_enable(!pause);
+}
+
+void scan_mask(uint16_t keys)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		scan_masked = keys;
+	}
+}
+
+uint16_t scan_get_mask(void)
+{
+	uint16_t keys;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		keys = scan_masked;
+	}
+	return keys;
+}
+
+uint8_t scan_read(scan_event_t *event)
+{
+	if (scan_head == scan_tail) return 0;
+	*event = scan_queue[scan_tail];
+	scan_tail = (scan_tail+1) & SCAN_QUEUE_MASK;
+	return 1;
+}
+
+uint16_t scan_state(void)
+{
+	uint16_t state;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		state = scan_keys.state;
+	}
+	return state;
+}
+
+uint32_t scan_time(void)
+{
+	uint32_t time;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		time = scan_ms;
+	}
+	return time;
+}
+
+uint16_t scan_errors(void)
+{
+	uint16_t errors;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		errors = scan_keys.ghosts + scan_lost;
+	}
+	return errors;
+}
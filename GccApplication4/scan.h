@@ -0,0 +1,146 @@
+/** \file scan.h
+*
+* \brief Interrupt driven keypad scanning.
+*
+* The keypad is scanned and debounced in the timer interrupt. Every
+* change of the debounced state is stored as an event in a queue
+* which is read by the main loop. Scan period and debounce depth can
+* be changed at any time without restarting the scanner.
+*
+* The scan rate adapts to the activity (see rate.h): the keypad is
+* scanned with the fast period while a key is pressed or a change is
+* pending and with the slow period after the quiet time.
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef SCAN_H_
+#define SCAN_H_
+
+#include <stdint.h>
+#include "rate.h"
+
+#ifndef SCAN_FAST_PERIOD
+#define SCAN_FAST_PERIOD 2000
+#endif
+#ifndef SCAN_SLOW_PERIOD
+#define SCAN_SLOW_PERIOD 20000
+#endif
+#ifndef SCAN_QUIET_TIME
+#define SCAN_QUIET_TIME 250
+#endif
+#define SCAN_PERIOD_MIN 250
+#define SCAN_PERIOD_MAX 60000
+#define SCAN_QUEUE_SIZE 16
+
+/// <summary>Key event.</summary>
+typedef struct {
+	uint16_t state;     ///< The debounced state.
+	uint16_t pressed;   ///< The newly pressed keys.
+	uint16_t released;  ///< The newly released keys.
+	uint16_t time;      ///< Time of the scan in milliseconds.
+	uint16_t stamp;     ///< Time stamp of the scan, see latency.h.
+} scan_event_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Start scanning.</summary>
+/// <remarks>
+/// Initializes the debouncer and starts the timer with the adaptive
+/// rate given by SCAN_FAST_PERIOD, SCAN_SLOW_PERIOD and
+/// SCAN_QUIET_TIME. The keypad must be initialized before. Low level
+/// interrupts must be enabled by the caller.
+/// </remarks>
+/// <param name="depth">The debounce depth.</param>
+void scan_init(uint8_t depth);
+
+/// <summary>Set a fixed scan period.</summary>
+/// <remarks>
+/// Sets the fast and the slow period to the same value.
+/// </remarks>
+/// <param name="period">The scan period in microseconds.</param>
+/// <returns>False if the period is out of range.</returns>
+uint8_t scan_period(uint16_t period);
+
+/// <summary>Set the adaptive scan rate.</summary>
+/// <param name="fast">The fast period in microseconds.</param>
+/// <param name="slow">The slow period in microseconds.</param>
+/// <param name="quiet">The quiet time in milliseconds.</param>
+/// <returns>False if a period is out of range or fast is slower than slow.</returns>
+uint8_t scan_rate(uint16_t fast, uint16_t slow, uint16_t quiet);
+
+/// <summary>Read the adaptive scan rate.</summary>
+/// <remarks>
+/// Returns a copy of the parameters and counters.
+/// </remarks>
+/// <param name="rate">Receives the copy.</param>
+void scan_get_rate(rate_t *rate);
+
+/// <summary>Read the scan period.</summary>
+/// <returns>The current scan period in microseconds.</returns>
+uint16_t scan_get_period(void);
+
+/// <summary>Change the debounce depth.</summary>
+/// <param name="depth">The debounce depth.</param>
+/// <returns>False if the depth is out of range.</returns>
+uint8_t scan_depth(uint8_t depth);
+
+/// <summary>Read the debounce depth.</summary>
+/// <returns>The debounce depth.</returns>
+uint8_t scan_get_depth(void);
+
+/// <summary>Pause or resume scanning.</summary>
+/// <remarks>
+/// While paused the keypad pins may be used by other modules, e.g. for
+/// capturing raw samples. The time does not advance.
+/// </remarks>
+/// <param name="pause">True to pause, false to resume.</param>
+void scan_pause(uint8_t pause);
+
+/// <summary>Exclude keys from scanning.</summary>
+/// <remarks>
+/// Masked keys are always read as released, e.g. the faulty keys found
+/// by <c>pad_test</c>. A masked key which is pressed is reported as
+/// released after debouncing.
+/// </remarks>
+/// <param name="keys">The keys to be excluded, 0 for none.</param>
+void scan_mask(uint16_t keys);
+
+/// <summary>Read the excluded keys.</summary>
+/// <returns>The keys excluded from scanning.</returns>
+uint16_t scan_get_mask(void);
+
+/// <summary>Read the next event.</summary>
+/// <param name="event">Receives the event.</param>
+/// <returns>True if an event has been read.</returns>
+uint8_t scan_read(scan_event_t *event);
+
+/// <summary>Read the debounced state.</summary>
+/// <returns>The debounced state.</returns>
+uint16_t scan_state(void);
+
+/// <summary>Read the time.</summary>
+/// <returns>Milliseconds since the start of the scanner.</returns>
+uint32_t scan_time(void);
+
+/// <summary>Read the error counter.</summary>
+/// <remarks>
+/// Counts samples ignored because of ghost patterns and events lost
+/// because the queue was full.
+/// </remarks>
+/// <returns>The number of errors.</returns>
+uint16_t scan_errors(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCAN_H_ */
@@ -0,0 +1,360 @@
+/*
+ * shell.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */ 
+
+#ifndef USE_FREERTOS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+
+#include "board.h"
+#include "usart.h"
+#include "pad.h"
+#include "scan.h"
+#include "output.h"
+#include "shortcut.h"
+#include "stats.h"
+#include "latency.h"
+#include "frame.h"
+#include "capture.h"
+#include "trace.h"
+#include "shell.h"
+
+typedef struct {
+	char name[8];
+	void (*handler)(const char *arg);
+} shell_command_t;
+
+static void shell_help(const char *arg);
+static void shell_period(const char *arg);
+static void shell_rate(const char *arg);
+static void shell_depth(const char *arg);
+static void shell_format(const char *arg);
+static void shell_baud(const char *arg);
+static void shell_flow(const char *arg);
+static void shell_mirror(const char *arg);
+static void shell_chord(const char *arg);
+static void shell_report(const char *arg);
+static void shell_test(const char *arg);
+static void shell_stats(const char *arg);
+static void shell_latency(const char *arg);
+static void shell_capture(const char *arg);
+#ifdef USE_TRACE
+static void shell_trace(const char *arg);
+#endif
+
+static const shell_command_t shell_commands[] PROGMEM = {
+	{ "help", shell_help },
+	{ "period", shell_period },
+	{ "rate", shell_rate },
+	{ "depth", shell_depth },
+	{ "format", shell_format },
+	{ "baud", shell_baud },
+	{ "flow", shell_flow },
+	{ "mirror", shell_mirror },
+	{ "chord", shell_chord },
+	{ "report", shell_report },
+	{ "test", shell_test },
+	{ "stats", shell_stats },
+	{ "latency", shell_latency },
+	{ "capture", shell_capture },
+#ifdef USE_TRACE
+	{ "trace", shell_trace },
+#endif
+};
+
+#define SHELL_COMMANDS (sizeof(shell_commands)/sizeof(shell_commands[0]))
+
+static char shell_line[SHELL_LINE_SIZE];
+static uint8_t shell_length;
+static uint8_t shell_overflow;
+
+static void shell_error(void)
+{
+	printf_P(PSTR("# error\n"));
+}
+
+/* Parses a number up to UINT16_MAX. Returns the end of the number or
+ * NULL if there is none or if it is too large. */
+static const char* shell_number(const char *arg, uint16_t *value)
+{
+	char *end;
+	unsigned long number = strtoul(arg,&end,10);
+	if (end == arg || number > UINT16_MAX) return NULL;
+	*value = number;
+	return end;
+}
+
+/* Parses an argument which consists of one number up to max. */
+static uint8_t shell_value(const char *arg, uint16_t max, uint16_t *value)
+{
+	arg = shell_number(arg,value);
+	return arg && *arg == '\0' && *value <= max;
+}
+
+static void shell_help(const char *arg)
+{
+	uint8_t i;
+	printf_P(PSTR("#"));
+	for (i=0;i<SHELL_COMMANDS;i++) printf_P(PSTR(" %S"), shell_commands[i].name);
+	printf_P(PSTR("\n"));
+}
+
+static void shell_period(const char *arg)
+{
+	uint16_t period;
+	if (arg && (!shell_value(arg,UINT16_MAX,&period) || !scan_period(period))) {
+		shell_error();
+		return;
+	}
+	printf_P(PSTR("# period %u\n"), scan_get_period());
+}
+
+static void shell_rate(const char *arg)
+{
+	rate_t rate;
+	uint16_t fast, slow, quiet;
+	if (arg) {
+		if ((arg = shell_number(arg,&fast))) arg = shell_number(arg,&slow);
+		if (arg) arg = shell_number(arg,&quiet);
+		if (!arg || *arg != '\0' || !scan_rate(fast,slow,quiet)) {
+			shell_error();
+			return;
+		}
+	}
+	scan_get_rate(&rate);
+	printf_P(PSTR("# rate %u %u %u time %lu %lu scans %lu %lu\n"),
+		rate.period[RATE_FAST], rate.period[RATE_SLOW], rate.quiet,
+		rate.time[RATE_FAST], rate.time[RATE_SLOW],
+		rate.scans[RATE_FAST], rate.scans[RATE_SLOW]);
+}
+
+static void shell_depth(const char *arg)
+{
+	uint16_t depth;
+	if (arg && (!shell_value(arg,UINT8_MAX,&depth) || !scan_depth(depth))) {
+		shell_error();
+		return;
+	}
+	printf_P(PSTR("# depth %u\n"), scan_get_depth());
+}
+
+static void shell_format(const char *arg)
+{
+	uint8_t format;
+	if (arg) {
+		for (format=0;format<OUTPUT_FORMATS;format++) {
+			if (strcmp_P(arg,output_name(format)) == 0) break;
+		}
+		if (!output_format(format)) {
+			shell_error();
+			return;
+		}
+	}
+	printf_P(PSTR("# format %S\n"), output_name(output_get_format()));
+}
+
+static void shell_baud(const char *arg)
+{
+	int bsel, bscale, clk2x, error;
+	long baud;
+	char *end;
+	if (!arg) {
+		baud = usart_get_baudrate(USART_CONSOLE);
+		error = usart_params(F_CPU,baud,&bsel,&bscale,&clk2x);
+		printf_P(PSTR("# baud %ld %d\n"), baud, error);
+		return;
+	}
+	if (strcmp_P(arg,PSTR("auto")) == 0) {
+		printf_P(PSTR("# baud auto\n"));
+		baud = usart_autobaud(USART_CONSOLE,SHELL_AUTOBAUD_TIMEOUT);
+		if (!baud) {
+			printf_P(PSTR("# timeout\n"));
+			return;
+		}
+		error = usart_params(F_CPU,baud,&bsel,&bscale,&clk2x);
+		printf_P(PSTR("# baud %ld %d\n"), baud, error);
+		return;
+	}
+	baud = strtoul(arg,&end,10);
+	error = usart_params(F_CPU,baud,&bsel,&bscale,&clk2x);
+	if (end == arg || *end || bsel < 0) {
+		shell_error();
+		return;
+	}
+	printf_P(PSTR("# baud %ld %d\n"), baud, error);
+	usart_baudrate(USART_CONSOLE,baud);
+}
+
+static void shell_flow(const char *arg)
+{
+	uint16_t threshold;
+	if (arg && (!shell_value(arg,UINT8_MAX,&threshold) || !usart_buffer_flow(USART_CONSOLE,threshold))) {
+		shell_error();
+		return;
+	}
+	printf_P(PSTR("# flow %u\n"), usart_buffer_get_flow(USART_CONSOLE));
+}
+
+static void shell_mirror(const char *arg)
+{
+	if (arg) {
+		if (strcmp_P(arg,PSTR("on")) == 0) usart_share_attach(&usart1,1);
+		else if (strcmp_P(arg,PSTR("off")) == 0) usart_share_attach(&usart1,0);
+		else {
+			shell_error();
+			return;
+		}
+	}
+	printf_P(PSTR("# mirror %S %u\n"), (usart1.share) ? PSTR("on") : PSTR("off"), usart1.share_skipped);
+}
+
+static void shell_chord(const char *arg)
+{
+	uint16_t timeout;
+	if (arg) {
+		if (!shell_value(arg,UINT16_MAX,&timeout)) {
+			shell_error();
+			return;
+		}
+		shortcut_timeout(timeout);
+	}
+	printf_P(PSTR("# chord %u %u\n"), shortcut_get_timeout(), shortcut_count());
+}
+
+static void shell_report(const char *arg)
+{
+	uint16_t period;
+	if (arg && (!shell_value(arg,UINT16_MAX,&period) || !output_report_period(period))) {
+		shell_error();
+		return;
+	}
+	printf_P(PSTR("# report %u\n"), output_get_report_period());
+}
+
+static void shell_test(const char *arg)
+{
+	pad_fault_t fault;
+	if (arg) {
+		if (strcmp_P(arg,PSTR("off")) == 0) scan_mask(0);
+		else shell_error();
+		return;
+	}
+	scan_pause(1);
+	pad_test(&fault);
+	scan_mask(fault.keys);
+	scan_pause(0);
+	shell_fault(&fault);
+}
+
+static void shell_stats(const char *arg)
+{
+	stats_print();
+}
+
+static void shell_latency(const char *arg)
+{
+	if (arg) {
+		if (strcmp_P(arg,PSTR("clear")) == 0) latency_clear();
+		else shell_error();
+		return;
+	}
+	latency_print();
+}
+
+static void shell_capture(const char *arg)
+{
+	const capture_t *capture;
+	uint8_t frame[FRAME_PAYLOAD_MAX+FRAME_OVERHEAD];
+	uint8_t payload[FRAME_PAYLOAD_MAX];
+	uint8_t length;
+	uint16_t line = 0, rate = CAPTURE_DEFAULT_RATE, duration = 500, i;
+	if (arg) arg = shell_number(arg,&line);
+	if (arg && *arg) arg = shell_number(arg,&rate);
+	if (arg && *arg) arg = shell_number(arg,&duration);
+	if (!arg || *arg || line >= PAD_ROWS || !CAPTURE_RATE_VALID(rate) || rate*64UL > F_CPU) {
+		shell_error();
+		return;
+	}
+	printf_P(PSTR("# capture %u %u %u\n"), line, rate, duration);
+	capture = capture_run(line,rate,SHELL_CAPTURE_TIMEOUT,(uint32_t)rate*duration/1000);
+	if (!capture) {
+		printf_P(PSTR("# timeout\n"));
+		return;
+	}
+	printf_P(PSTR("# runs %u samples %lu\n"), capture->runs, capture->samples);
+	for (i=0,length=0;i<capture->runs;i++) {
+		payload[length++] = capture->run[i] & 0xFF;
+		payload[length++] = capture->run[i] >> 8;
+		if (length == FRAME_PAYLOAD_MAX || i == capture->runs-1) {
+			usart_buffer_write(USART_CONSOLE,frame,frame_encode(frame,FRAME_CAPTURE,payload,length));
+			length = 0;
+		}
+	}
+	printf_P(PSTR("# end\n"));
+}
+
+#ifdef USE_TRACE
+static void shell_trace(const char *arg)
+{
+	if (!arg) trace_dump();
+	else if (strcmp_P(arg,PSTR("ring")) == 0) trace_mode(TRACE_RING);
+	else if (strcmp_P(arg,PSTR("once")) == 0) trace_mode(TRACE_ONCE);
+	else if (strcmp_P(arg,PSTR("off")) == 0) trace_mode(TRACE_OFF);
+	else shell_error();
+}
+#endif
+
+void shell_fault(const pad_fault_t *fault)
+{
+	printf_P(PSTR("# test %02x %02x %02x %04x %04x\n"), fault->high, fault->low, fault->shorted, fault->closed, fault->keys);
+}
+
+static void shell_execute(char *line)
+{
+	char *arg = strchr(line,' ');
+	uint8_t i;
+	void (*handler)(const char*);
+	if (arg) {
+		*arg++ = '\0';
+		while (*arg == ' ') arg++;
+		if (*arg == '\0') arg = NULL;
+	}
+	for (i=0;i<SHELL_COMMANDS;i++) {
+		if (strcmp_P(line,shell_commands[i].name) == 0) {
+			handler = (void (*)(const char*))pgm_read_ptr(&shell_commands[i].handler);
+			handler(arg);
+			return;
+		}
+	}
+	shell_error();
+}
+
+void shell_input(char c)
+{
+	if (c == '\r' || c == '\n') {
+		if (shell_length && !shell_overflow) {
+			shell_line[shell_length] = '\0';
+			shell_execute(shell_line);
+		}
+		shell_length = 0;
+		shell_overflow = 0;
+	}
+	else if (c == '\b' || c == 0x7F) {
+		if (shell_length) shell_length--;
+	}
+	else if (shell_length < SHELL_LINE_SIZE-1) {
+		shell_line[shell_length++] = c;
+	}
+	else {
+		shell_overflow = 1;
+	}
+}
+
+#endif /* USE_FREERTOS */
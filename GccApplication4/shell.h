@@ -0,0 +1,99 @@
+/** \file shell.h
+*
+* \brief Command interpreter for runtime configuration.
+*
+* The shell reads lines from the USART and executes the commands
+* defined in a table in PROGMEM. Commands without an argument print
+* the current value, commands with an argument change it. All
+* replies are lines starting with #. Numbers are decimal and, except
+* for baud rates, at most 65535. Invalid arguments are answered with
+* "# error" and change nothing. The shell uses a static line buffer
+* and no heap.
+*
+* | Command | Argument               | Description                      |
+* |---------|------------------------|----------------------------------|
+* | help    |                        | List the commands.               |
+* | period  | microseconds           | Fixed scan period.               |
+* | rate    | fast slow quiet        | Adaptive scan rate. Periods in   |
+* |         |                        | microseconds, quiet time in      |
+* |         |                        | milliseconds. Also prints the    |
+* |         |                        | time and scans at each rate.     |
+* | depth   | 1..8                   | Debounce depth.                  |
+* | format  | off, hex, frame        | Output format.                   |
+* | baud    | baud rate, auto        | Baud rate of the USART. With     |
+* |         |                        | auto the rate is measured from   |
+* |         |                        | 'U' sent by the host (see        |
+* |         |                        | usart_autobaud). Also prints the |
+* |         |                        | deviation in per mill.           |
+* | flow    | threshold              | RTS/CTS flow control. RTS is     |
+* |         |                        | deasserted at this fill level of |
+* |         |                        | the receive buffer, 0 disables.  |
+* | mirror  | on, off                | Mirror the key event frames to   |
+* |         |                        | usart1. Also prints the number   |
+* |         |                        | of records it skipped.           |
+* | chord   | milliseconds           | Maximum time between the steps   |
+* |         |                        | of a chord or sequence (see      |
+* |         |                        | shortcut.h), 0 waits forever.    |
+* |         |                        | Also prints the number of        |
+* |         |                        | patterns.                        |
+* | report  | milliseconds           | Period of the key reports (see   |
+* |         |                        | report.h), 0 switches them off.  |
+* | test    | [off]                  | Run the self-test of the matrix  |
+* |         |                        | and exclude the faulty keys from |
+* |         |                        | scanning (see pad_test). Closed  |
+* |         |                        | keys are only reported. off      |
+* |         |                        | scans all keys again.            |
+* | stats   |                        | Print the statistics.            |
+* | latency | [clear]                | Print or clear the latency of    |
+* |         |                        | the event frames (see latency.h).|
+* | capture | line [rate [ms]]       | Capture the sense lines of a     |
+* |         |                        | drive line (see capture.h) and   |
+* |         |                        | dump the runs as frames.         |
+* | trace   | [ring, once, off]      | Set the trace mode or dump the   |
+* |         |                        | buffer (see trace.h). Only with  |
+* |         |                        | USE_TRACE.                       |
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef SHELL_H_
+#define SHELL_H_
+
+#include "pad.h"
+
+#define SHELL_LINE_SIZE 32
+#define SHELL_CAPTURE_TIMEOUT 10000
+#define SHELL_AUTOBAUD_TIMEOUT 10000
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Process a received character.</summary>
+/// <remarks>
+/// Collects the characters of a line and executes the command at the
+/// end of the line. Lines longer than SHELL_LINE_SIZE are discarded.
+/// </remarks>
+/// <param name="c">The received character.</param>
+void shell_input(char c);
+
+/// <summary>Print the result of a self-test.</summary>
+/// <remarks>
+/// Prints the line "# test high low shorted closed keys" with the
+/// fields of <c>pad_fault_t</c> in hex. Also used at boot if a fault
+/// or a closed key has been found.
+/// </remarks>
+/// <param name="fault">The result of <c>pad_test</c>.</param>
+void shell_fault(const pad_fault_t *fault);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHELL_H_ */
@@ -0,0 +1,60 @@
+/*
+ * shortcut.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */
+
+#ifndef USE_FREERTOS
+
+#include <avr/pgmspace.h>
+
+#include "pad.h"
+#include "chord.h"
+#include "output.h"
+#include "shortcut.h"
+
+/* Must be sorted by the steps, see chord.h. */
+static const chord_pattern_t shortcut_patterns[] PROGMEM = {
+	{ { PAD_KEY_STAR_bm, PAD_KEY_STAR_bm, PAD_KEY_0_bm }, SHORTCUT_RESET },
+	{ { PAD_KEY_STAR_bm | PAD_KEY_HASH_bm }, SHORTCUT_SERVICE },
+	{ { PAD_KEY_1_bm, PAD_KEY_2_bm, PAD_KEY_3_bm, PAD_KEY_4_bm, PAD_KEY_HASH_bm }, SHORTCUT_PIN },
+};
+
+#define SHORTCUT_PATTERNS (sizeof(shortcut_patterns)/sizeof(shortcut_patterns[0]))
+
+static chord_t shortcut_chord;
+
+uint8_t shortcut_init(void)
+{
+	return chord_init(&shortcut_chord,shortcut_patterns,SHORTCUT_PATTERNS,SHORTCUT_TIMEOUT);
+}
+
+void shortcut_event(const scan_event_t *event)
+{
+	chord_event(&shortcut_chord,event->pressed,event->released,event->time);
+}
+
+void shortcut_task(uint32_t time)
+{
+	uint8_t id;
+	while ((id = chord_read(&shortcut_chord,time)) != CHORD_NONE) output_match(id,time);
+}
+
+void shortcut_timeout(uint16_t timeout)
+{
+	chord_timeout(&shortcut_chord,timeout);
+}
+
+uint16_t shortcut_get_timeout(void)
+{
+	return shortcut_chord.timeout;
+}
+
+uint16_t shortcut_count(void)
+{
+	return shortcut_chord.count;
+}
+
+#endif /* USE_FREERTOS */
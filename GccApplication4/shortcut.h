@@ -0,0 +1,74 @@
+/** \file shortcut.h
+*
+* \brief Chords and sequences of the application.
+*
+* Feeds the key events into the recognizer of chord.h with the table
+* of patterns below and writes every match with <c>output_match</c>.
+*
+* | Id | Pattern            | Description                           |
+* |----|--------------------|---------------------------------------|
+* |  1 | * and # together   | Service mode.                         |
+* |  2 | 1 2 3 4 #          | PIN entry.                            |
+* |  3 | * * 0              | Reset.                                |
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef SHORTCUT_H_
+#define SHORTCUT_H_
+
+#include <stdint.h>
+#include "scan.h"
+
+/// \def SHORTCUT_TIMEOUT
+/// <summary>Default maximum time between two steps in milliseconds.</summary>
+#ifndef SHORTCUT_TIMEOUT
+#define SHORTCUT_TIMEOUT 1500
+#endif
+
+#define SHORTCUT_SERVICE 1
+#define SHORTCUT_PIN     2
+#define SHORTCUT_RESET   3
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Initialize the recognizer.</summary>
+/// <returns>False if the table of patterns is invalid.</returns>
+uint8_t shortcut_init(void);
+
+/// <summary>Process a key event.</summary>
+/// <param name="event">The key event.</param>
+void shortcut_event(const scan_event_t *event);
+
+/// <summary>Write the matches.</summary>
+/// <remarks>
+/// Must be called periodically from the main loop.
+/// </remarks>
+/// <param name="time">The time in milliseconds.</param>
+void shortcut_task(uint32_t time);
+
+/// <summary>Change the timeout.</summary>
+/// <param name="timeout">Maximum time between steps in milliseconds, 0 waits forever.</param>
+void shortcut_timeout(uint16_t timeout);
+
+/// <summary>Read the timeout.</summary>
+/// <returns>Maximum time between steps in milliseconds.</returns>
+uint16_t shortcut_get_timeout(void);
+
+/// <summary>Read the number of patterns.</summary>
+/// <returns>The number of patterns, 0 if the table is invalid.</returns>
+uint16_t shortcut_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHORTCUT_H_ */
@@ -0,0 +1,170 @@
+/*
+ * stats.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */ 
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <util/crc16.h>
+
+#include "board.h"
+#include "stats.h"
+
+typedef struct {
+	uint16_t sequence;
+	stats_t stats;
+	uint16_t crc;
+} stats_record_t;
+
+#define STATS_RECORD_PAGES ((sizeof(stats_record_t)+EEPROM_PAGE_SIZE-1)/EEPROM_PAGE_SIZE)
+#define STATS_SLOT_SIZE (STATS_RECORD_PAGES*EEPROM_PAGE_SIZE)
+#define STATS_SLOTS (EEPROM_SIZE/STATS_SLOT_SIZE)
+
+enum { STATS_IDLE, STATS_WRITE };
+
+static stats_t stats;
+static stats_record_t stats_record;
+static uint8_t stats_slot;
+static uint8_t stats_page;
+static uint8_t stats_state;
+static uint8_t stats_dirty;
+static uint8_t stats_requested;
+
+static void stats_nvm_execute(uint8_t cmd, uint16_t addr)
+{
+	NVM.ADDR0 = addr & 0xFF;
+	NVM.ADDR1 = addr >> 8;
+	NVM.ADDR2 = 0;
+	NVM.CMD = cmd;
+	CCP = CCP_IOREG_gc;
+	NVM.CTRLA = NVM_CMDEX_bm;
+}
+
+static uint8_t stats_nvm_read(uint16_t addr)
+{
+	while (NVM.STATUS & NVM_NVMBUSY_bm);
+	stats_nvm_execute(NVM_CMD_READ_EEPROM_gc,addr);
+	NVM.CMD = NVM_CMD_NO_OPERATION_gc;
+	return NVM.DATA0;
+}
+
+static void stats_nvm_load(const uint8_t *data, uint16_t addr)
+{
+	uint8_t i;
+	NVM.CMD = NVM_CMD_LOAD_EEPROM_BUFFER_gc;
+	NVM.ADDR1 = addr >> 8;
+	NVM.ADDR2 = 0;
+	for (i=0;i<EEPROM_PAGE_SIZE;i++) {
+		NVM.ADDR0 = (addr+i) & 0xFF;
+		NVM.DATA0 = data[i];
+	}
+}
+
+static uint16_t stats_crc(const stats_record_t *record)
+{
+	const uint8_t *data = (const uint8_t*)record;
+	uint16_t crc = 0xFFFF;
+	uint8_t i;
+	for (i=0;i<offsetof(stats_record_t,crc);i++) crc = _crc_ccitt_update(crc,data[i]);
+	return crc;
+}
+
+void stats_init(void)
+{
+	stats_record_t record;
+	uint8_t *data = (uint8_t*)&record;
+	uint8_t slot, i, found = 0;
+	uint16_t sequence = 0;
+	for (slot=0;slot<STATS_SLOTS;slot++) {
+		for (i=0;i<sizeof(record);i++) data[i] = stats_nvm_read(slot*STATS_SLOT_SIZE+i);
+		if (record.crc != stats_crc(&record)) continue;
+		if (found && (int16_t)(record.sequence-sequence) <= 0) continue;
+		found = 1;
+		sequence = record.sequence;
+		stats_slot = slot;
+		stats = record.stats;
+	}
+	if (!found) {
+		memset(&stats,0,sizeof(stats));
+		stats_slot = STATS_SLOTS-1;
+	}
+	stats_record.sequence = sequence;
+	stats.boots++;
+	stats_dirty = 1;
+	stats_requested = 1;
+}
+
+void stats_press(uint16_t pressed)
+{
+	uint8_t key;
+	for (key=0;pressed;key++,pressed>>=1) {
+		if (pressed & 1) {
+			stats.presses[key]++;
+			stats_dirty = 1;
+		}
+	}
+}
+
+void stats_error(void)
+{
+	stats.errors++;
+	stats_dirty = 1;
+}
+
+void stats_flush(void)
+{
+	stats_requested = 1;
+}
+
+void stats_task(void)
+{
+	uint8_t page[EEPROM_PAGE_SIZE];
+	uint8_t offset, length;
+	uint16_t addr;
+	if (NVM.STATUS & NVM_NVMBUSY_bm) return;
+	switch (stats_state) {
+		case STATS_IDLE:
+			if (!stats_requested || !stats_dirty) return;
+			stats_record.sequence++;
+			stats_record.stats = stats;
+			stats_record.crc = stats_crc(&stats_record);
+			stats_slot = (stats_slot+1) % STATS_SLOTS;
+			stats_page = 0;
+			stats_requested = 0;
+			stats_dirty = 0;
+			stats_state = STATS_WRITE;
+			break;
+		case STATS_WRITE:
+			offset = stats_page*EEPROM_PAGE_SIZE;
+			length = sizeof(stats_record)-offset;
+			if (length > EEPROM_PAGE_SIZE) length = EEPROM_PAGE_SIZE;
+			memset(page,0xFF,sizeof(page));
+			memcpy(page,(const uint8_t*)&stats_record+offset,length);
+			addr = stats_slot*STATS_SLOT_SIZE+offset;
+			stats_nvm_load(page,addr);
+			stats_nvm_execute(NVM_CMD_ERASE_WRITE_EEPROM_PAGE_gc,addr);
+			if (++stats_page >= STATS_RECORD_PAGES) stats_state = STATS_IDLE;
+			break;
+	}
+}
+
+const stats_t* stats_get(void)
+{
+	return &stats;
+}
+
+void stats_print(void)
+{
+	uint8_t key;
+	printf_P(PSTR("# boots %u errors %lu\n# presses"), stats.boots, stats.errors);
+	for (key=STATS_KEYS;key>0;key--) {
+		printf_P(PSTR(" %c:%lu"), PAD_KEY_NAMES[key-1], stats.presses[key-1]);
+	}
+	printf_P(PSTR("\n"));
+}
@@ -0,0 +1,92 @@
+/** \file stats.h
+*
+* \brief Persistent keypad statistics.
+*
+* The module counts the presses of every key, the boots and the scan
+* errors in RAM. On request the counters are written into the EEPROM
+* as one record. Records are written round robin into a ring of slots
+* so that the EEPROM wears evenly. Every record carries a sequence
+* number and a CRC. At boot the valid record with the highest
+* sequence number is loaded.
+*
+* Records are written through the EEPROM page buffer. <c>stats_task</c>
+* starts at most one page write per call and returns immediately if
+* the NVM controller is busy, so flushing never stalls the caller.
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdint.h>
+#include "pad.h"
+
+#define STATS_KEYS (PAD_COLS*PAD_ROWS)
+
+/// \def STATS_FLUSH_PERIOD
+/// <summary>Period of the flushes in seconds.</summary>
+#ifndef STATS_FLUSH_PERIOD
+#define STATS_FLUSH_PERIOD 600
+#endif
+
+/// <summary>The statistics.</summary>
+typedef struct {
+	uint16_t boots;                ///< Number of boots.
+	uint32_t errors;               ///< Number of scan errors.
+	uint32_t presses[STATS_KEYS];  ///< Presses per key indexed by bit.
+} stats_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Initialize the statistics.</summary>
+/// <remarks>
+/// Loads the most recent valid record from the EEPROM and counts
+/// the boot. Blocks while reading the EEPROM.
+/// </remarks>
+void stats_init(void);
+
+/// <summary>Count key presses.</summary>
+/// <param name="pressed">The newly pressed keys.</param>
+void stats_press(uint16_t pressed);
+
+/// <summary>Count a scan error.</summary>
+void stats_error(void);
+
+/// <summary>Request a flush.</summary>
+/// <remarks>
+/// The counters are written by the following calls of
+/// <c>stats_task</c> if they have changed since the last flush.
+/// </remarks>
+void stats_flush(void);
+
+/// <summary>Write the statistics into the EEPROM.</summary>
+/// <remarks>
+/// Must be called periodically from the main loop. Starts at most one
+/// page write per call and never waits for the NVM controller.
+/// </remarks>
+void stats_task(void);
+
+/// <summary>Read the statistics.</summary>
+/// <returns>The statistics.</returns>
+const stats_t* stats_get(void);
+
+/// <summary>Print the statistics.</summary>
+/// <remarks>
+/// Prints the statistics to stdout as comment lines starting with #.
+/// </remarks>
+void stats_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STATS_H_ */
@@ -0,0 +1,52 @@
+/*
+ * timer.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */ 
+
+#include <stddef.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "board.h"
+#include "timer.h"
+#include "trace.h"
+
+static void (*timer_callback)(void);
+
+void timer_init(uint16_t period, void (*callback)(void))
+{
+	timer_callback = callback;
+	TIMER_MODULE.CTRLA = TC_CLKSEL_OFF_gc;
+	TIMER_MODULE.CTRLB = TC_WGMODE_NORMAL_gc;
+	TIMER_MODULE.CNT = 0;
+	TIMER_MODULE.PER = TIMER_TICKS(period) - 1;
+	TIMER_MODULE.INTCTRLA = TC_OVFINTLVL_LO_gc;
+	TIMER_MODULE.CTRLA = TIMER_CLKSEL;
+}
+
+void timer_period(uint16_t period)
+{
+	TIMER_MODULE.PERBUF = TIMER_TICKS(period) - 1;
+}
+
+void timer_enable(uint8_t enable)
+{
+	TIMER_MODULE.INTFLAGS = TC0_OVFIF_bm;
+	TIMER_MODULE.INTCTRLA = (enable) ? TC_OVFINTLVL_LO_gc : TC_OVFINTLVL_OFF_gc;
+}
+
+void timer_next(uint16_t period)
+{
+	TIMER_MODULE.PER = TIMER_TICKS(period) - 1;
+	TIMER_MODULE.PERBUF = TIMER_MODULE.PER;
+}
+
+ISR(TIMER_OVF_vect)
+{
+	TRACE_ENTER(TRACE_TIMER_ISR);
+	if (timer_callback != NULL) timer_callback();
+	TRACE_LEAVE(TRACE_TIMER_ISR);
+}
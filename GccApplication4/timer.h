@@ -0,0 +1,78 @@
+/** \file timer.h
+*
+* \brief Periodic timer interrupt.
+*
+* TCC0 generates a low level overflow interrupt with a given period
+* and calls a user supplied function from the interrupt. TCC1 remains
+* free for the FreeRTOS tick.
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef TIMER_H_
+#define TIMER_H_
+
+#include <stdint.h>
+
+#define TIMER_MODULE TCC0
+#define TIMER_OVF_vect TCC0_OVF_vect
+#define TIMER_PRESCALER 64
+#define TIMER_CLKSEL TC_CLKSEL_DIV64_gc
+
+/// \def TIMER_TICKS(US)
+/// <summary>Convert microseconds to timer ticks.</summary>
+/// <remarks>
+/// The product of up to 65535 us and F_CPU in kHz fits into 32 bits up
+/// to 65 MHz. The result must fit into 16 bits, see scan.c.
+/// </remarks>
+#define TIMER_TICKS(US) ((uint16_t)((uint32_t)(US) * (F_CPU / 1000UL) / (TIMER_PRESCALER * 1000UL)))
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Initialize the periodic timer.</summary>
+/// <remarks>
+/// Starts TCC0 with the given period and enables its low level
+/// overflow interrupt. The callback is executed in interrupt context
+/// and must be short. Low level interrupts must be enabled in the PMIC
+/// and globally by the caller.
+/// </remarks>
+/// <param name="period">The period in microseconds.</param>
+/// <param name="callback">The function called on every period.</param>
+void timer_init(uint16_t period, void (*callback)(void));
+
+/// <summary>Change the period of the timer.</summary>
+/// <remarks>
+/// The new period takes effect with the next overflow. The timer
+/// is not restarted.
+/// </remarks>
+/// <param name="period">The period in microseconds.</param>
+void timer_period(uint16_t period);
+
+/// <summary>Enable or disable the timer interrupt.</summary>
+/// <remarks>
+/// The timer keeps running. While disabled the callback is not called.
+/// </remarks>
+/// <param name="enable">True to enable the interrupt.</param>
+void timer_enable(uint8_t enable);
+
+/// <summary>Change the period of the current interval.</summary>
+/// <remarks>
+/// Must only be called from the callback. The new period applies to
+/// the interval which has just started.
+/// </remarks>
+/// <param name="period">The period in microseconds.</param>
+void timer_next(uint16_t period);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMER_H_ */
@@ -0,0 +1,103 @@
+/*
+ * trace.c
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */
+
+#ifdef USE_TRACE
+
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#include "board.h"
+#include "usart.h"
+#include "frame.h"
+#include "trace.h"
+
+#define TRACE_FRAME_RECORDS (FRAME_PAYLOAD_MAX/3)
+
+trace_buffer_t trace_buffers[TRACE_CONTEXTS];
+volatile uint8_t trace_state;
+
+void trace_init(void)
+{
+	trace_state = TRACE_OFF;
+	PORTCFG.VPCTRLB = (PORTCFG.VPCTRLB & ~PORTCFG_VP2MAP_gm) | TRACE_MARKER_MAP;
+	TRACE_MARKER_PORT.OUTCLR = TRACE_MARKER_bm;
+	TRACE_MARKER_PORT.DIRSET = TRACE_MARKER_bm;
+	TRACE_TIMER.CTRLA = TC_CLKSEL_OFF_gc;
+	TRACE_TIMER.CTRLB = TC_WGMODE_NORMAL_gc;
+	TRACE_TIMER.PER = 0xFFFF;
+	TRACE_TIMER.CNT = 0;
+	TRACE_TIMER.CTRLA = TRACE_CLKSEL;
+}
+
+/* Interrupts only record while the mode is on, so the buffers can be
+ * cleared without disabling them. */
+void trace_mode(uint8_t mode)
+{
+	uint8_t c;
+	trace_state = TRACE_OFF;
+	for (c=0;c<TRACE_CONTEXTS;c++) {
+		trace_buffers[c].head = 0;
+		trace_buffers[c].wrapped = 0;
+	}
+	trace_state = mode;
+}
+
+/* Walks back from now and takes the newer of the two records left in
+ * the buffers, remembering the choices in a bit field. The records are
+ * then written in the reverse order of the choices. */
+void trace_dump(void)
+{
+	uint8_t frame[FRAME_SIZE_MAX];
+	uint8_t payload[FRAME_PAYLOAD_MAX];
+	uint8_t order[TRACE_CONTEXTS*TRACE_RECORDS/8];
+	uint8_t index[TRACE_CONTEXTS], left[TRACE_CONTEXTS];
+	uint8_t mode = trace_state, c, length;
+	uint16_t count, i, time;
+	const trace_record_t *record[TRACE_CONTEXTS];
+	trace_state = TRACE_OFF;
+	time = TRACE_TIMER.CNT;
+	for (c=0,count=0;c<TRACE_CONTEXTS;c++) {
+		index[c] = trace_buffers[c].head;
+		left[c] = (trace_buffers[c].wrapped) ? TRACE_RECORDS : index[c];
+		count += left[c];
+	}
+	for (i=0;i<count;i++) {
+		for (c=0;c<TRACE_CONTEXTS;c++) record[c] = &trace_buffers[c].record[(index[c]-1) & TRACE_MASK];
+		if (!left[TRACE_ISR]) c = TRACE_MAIN;
+		else if (!left[TRACE_MAIN]) c = TRACE_ISR;
+		else c = ((uint16_t)(time-record[TRACE_ISR]->time) <= (uint16_t)(time-record[TRACE_MAIN]->time)) ? TRACE_ISR : TRACE_MAIN;
+		if (c == TRACE_MAIN) order[i/8] |= 1<<(i%8);
+		else order[i/8] &= ~(1<<(i%8));
+		time = record[c]->time;
+		index[c] = (index[c]-1) & TRACE_MASK;
+		left[c]--;
+	}
+	printf_P(PSTR("# trace %u %lu\n"), count, (unsigned long)TRACE_CLOCK);
+	for (i=count,length=0;i-- > 0;) {
+		c = (order[i/8] & (1<<(i%8))) ? TRACE_MAIN : TRACE_ISR;
+		record[c] = &trace_buffers[c].record[index[c]];
+		index[c] = (index[c]+1) & TRACE_MASK;
+		payload[length++] = record[c]->id;
+		payload[length++] = record[c]->time & 0xFF;
+		payload[length++] = record[c]->time >> 8;
+		if (length == TRACE_FRAME_RECORDS*3 || i == 0) {
+			usart_buffer_write(USART_CONSOLE,frame,frame_encode(frame,FRAME_TRACE,payload,length));
+			length = 0;
+		}
+	}
+	printf_P(PSTR("# end\n"));
+	trace_mode((mode == TRACE_FULL) ? TRACE_OFF : mode);
+}
+
+void trace_task(void)
+{
+	if (trace_state == TRACE_FULL) trace_dump();
+}
+
+#endif
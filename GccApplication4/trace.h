@@ -0,0 +1,205 @@
+/** \file trace.h
+*
+* \brief Tracing of interrupts and main loop stages.
+*
+* Trace points write records of an identifier and a time stamp into a
+* circular buffer in SRAM. The identifier of an exit record has the
+* bit TRACE_EXIT_bm set. The time stamp is the counter of the free
+* running timer TRACE_TIMER which runs with TRACE_CLOCK ticks per
+* second and wraps every 65536 ticks.
+*
+* The trace points up to TRACE_DRE_ISR are in interrupts, all others in
+* the main loop. Each context has its own buffer of TRACE_RECORDS
+* records whose index only this context writes, so a trace point is a
+* few inline stores without disabling interrupts. All interrupts are
+* low level and never nest. Interrupts save and restore the TEMP
+* register of TRACE_TIMER because they may interrupt a read of the
+* counter in the main loop.
+*
+* In mode TRACE_RING the oldest records are overwritten and the buffers
+* hold the latest history. In mode TRACE_ONCE recording stops when one
+* buffer is full and <c>trace_task</c> dumps them. The dump merges the
+* buffers by time stamp, which is exact while both contexts record at
+* least every 65536 ticks, e.g. with the scan timer running. It
+* consists of the line "# trace records clock", FRAME_TRACE frames and
+* the line "# end". tools/trace.py converts it into the Chrome trace
+* format.
+*
+* The trace point whose identifier equals TRACE_MARKER additionally
+* sets the pin PF0 (jumper J1 pin 1) on enter and clears it on exit
+* for the correlation with a logic analyzer.
+*
+* Tracing is only compiled if USE_TRACE is defined. Otherwise the trace
+* points are empty. Because it changes the timing of the interrupts it
+* is not defined in any build configuration. To enable it add USE_TRACE
+* to the symbols of the configuration (Toolchain, AVR/GNU C Compiler,
+* Symbols) or pass -DUSE_TRACE to the compiler.
+*
+* \author    Wolfgang Neff
+* \version   1.0
+* \date      2026-10-19
+*
+* \par History
+*      Created: 2026-10-19
+*/
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdint.h>
+
+#if defined(USE_TRACE) && defined(USE_FREERTOS)
+#error "tracing is not supported in the FreeRTOS build"
+#endif
+
+#define TRACE_TIMER TCE0
+#define TRACE_CLKSEL TC_CLKSEL_DIV8_gc
+#define TRACE_CLOCK (F_CPU/8)
+
+#ifndef TRACE_RECORDS
+#define TRACE_RECORDS 64
+#endif
+#define TRACE_MASK (TRACE_RECORDS-1)
+
+#if (TRACE_RECORDS & TRACE_MASK) || TRACE_RECORDS > 128
+#error "TRACE_RECORDS must be a power of two up to 128"
+#endif
+
+#define TRACE_MARKER_PORT PORTF
+#define TRACE_MARKER_VPORT VPORT2
+#define TRACE_MARKER_MAP PORTCFG_VP2MAP_PORTF_gc
+#define TRACE_MARKER_bm PIN0_bm
+
+#define TRACE_EXIT_bm 0x80
+
+/* Trace points */
+#define TRACE_TIMER_ISR  1    /* Scan timer interrupt         */
+#define TRACE_SCAN       2    /* pad_scan                     */
+#define TRACE_RXC_ISR    3    /* USART receive interrupt      */
+#define TRACE_DRE_ISR    4    /* USART data register empty    */
+#define TRACE_EVENTS     5    /* Main loop: key events        */
+#define TRACE_OUTPUT     6    /* Main loop: output_task       */
+#define TRACE_SHELL      7    /* Main loop: shell input       */
+#define TRACE_STATS      8    /* Main loop: statistics        */
+#define TRACE_DISPATCH   9    /* pad_dispatch of one event    */
+
+#ifndef TRACE_MARKER
+#define TRACE_MARKER TRACE_SCAN
+#endif
+
+/* Contexts */
+#define TRACE_ISR  0
+#define TRACE_MAIN 1
+#define TRACE_CONTEXTS 2
+#define TRACE_CONTEXT(ID) ((((ID) & ~TRACE_EXIT_bm) <= TRACE_DRE_ISR) ? TRACE_ISR : TRACE_MAIN)
+
+/* Modes */
+#define TRACE_OFF  0
+#define TRACE_RING 1
+#define TRACE_ONCE 2
+#define TRACE_FULL 3
+
+/// <summary>A trace record.</summary>
+typedef struct {
+	uint8_t id;     ///< Trace point, TRACE_EXIT_bm set on exit.
+	uint16_t time;  ///< Counter of TRACE_TIMER.
+} trace_record_t;
+
+/// <summary>The buffer of a context.</summary>
+typedef struct {
+	trace_record_t record[TRACE_RECORDS]; ///< The records.
+	volatile uint8_t head;                ///< Index of the next record.
+	volatile uint8_t wrapped;             ///< True once the buffer was full.
+} trace_buffer_t;
+
+#ifdef USE_TRACE
+#include <avr/io.h>
+
+extern trace_buffer_t trace_buffers[TRACE_CONTEXTS];
+extern volatile uint8_t trace_state;
+
+/// <summary>Write a record.</summary>
+/// <remarks>
+/// Used by the trace points. The context is known at compile time, so
+/// only the stores into its buffer remain.
+/// </remarks>
+/// <param name="id">The trace point, TRACE_EXIT_bm set on exit.</param>
+static inline void trace_record(uint8_t id)
+{
+	trace_buffer_t *buffer = &trace_buffers[TRACE_CONTEXT(id)];
+	trace_record_t *record;
+	uint8_t head, temp;
+	if (trace_state != TRACE_RING && trace_state != TRACE_ONCE) return;
+	head = buffer->head;
+	record = &buffer->record[head];
+	record->id = id;
+	if (TRACE_CONTEXT(id) == TRACE_ISR) {
+		temp = TRACE_TIMER.TEMP;
+		record->time = TRACE_TIMER.CNT;
+		TRACE_TIMER.TEMP = temp;
+	}
+	else {
+		record->time = TRACE_TIMER.CNT;
+	}
+	head = (head+1) & TRACE_MASK;
+	buffer->head = head;
+	if (head == 0) {
+		buffer->wrapped = 1;
+		if (trace_state == TRACE_ONCE) trace_state = TRACE_FULL;
+	}
+}
+
+/// \def TRACE_ENTER(ID)
+/// <summary>Record the entry of a trace point.</summary>
+/// <param name="ID">The trace point.</param>
+#define TRACE_ENTER(ID) do { \
+	if ((ID) == TRACE_MARKER) TRACE_MARKER_VPORT.OUT |= TRACE_MARKER_bm; \
+	trace_record(ID); \
+} while (0)
+
+/// \def TRACE_LEAVE(ID)
+/// <summary>Record the exit of a trace point.</summary>
+/// <param name="ID">The trace point.</param>
+#define TRACE_LEAVE(ID) do { \
+	trace_record((ID) | TRACE_EXIT_bm); \
+	if ((ID) == TRACE_MARKER) TRACE_MARKER_VPORT.OUT &= ~TRACE_MARKER_bm; \
+} while (0)
+#else
+#define TRACE_ENTER(ID) do { } while (0)
+#define TRACE_LEAVE(ID) do { } while (0)
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// <summary>Initialize tracing.</summary>
+/// <remarks>
+/// Starts TRACE_TIMER, maps PORTF to TRACE_MARKER_VPORT and configures
+/// the marker pin as output. Tracing is off.
+/// </remarks>
+void trace_init(void);
+
+/// <summary>Set the mode.</summary>
+/// <remarks>Clears the buffers.</remarks>
+/// <param name="mode">TRACE_OFF, TRACE_RING or TRACE_ONCE.</param>
+void trace_mode(uint8_t mode);
+
+/// <summary>Dump the buffers.</summary>
+/// <remarks>
+/// Stops recording, writes the merged records into the USART transmit
+/// buffer, clears the buffers and continues in the previous mode. A
+/// full buffer of mode TRACE_ONCE switches tracing off.
+/// </remarks>
+void trace_dump(void);
+
+/// <summary>Dump the buffers once one is full.</summary>
+/// <remarks>Must be called periodically from the main loop.</remarks>
+void trace_task(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_H_ */
@@ -1,155 +1,704 @@
 /*
  * usart.c
  *
- * Version: 1.2
+ * Version: 1.4
  * Created: 2012-09-03
  * Modified: 2014-10-17
  * Modified: 2015-01-28
+ * Modified: 2026-10-19
  *  Author: Wolfgang Neff
  */ 
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
 
 #include "board.h"
 #include "usart.h"
+#include "trace.h"
+#include "latency.h"
 
-#define LIMIT ((1<<(USART_BSEL_BITS+1))-1)
-#define USART_ERROR_CODE ((USART_MODULE.STATUS & 0x001C) << 6)
+#ifdef USE_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stream_buffer.h"
+#endif
+
+#define USART_ERROR_CODE(usart) (((usart)->module->STATUS & 0x001C) << 6)
+
+/* Clears TXCIF with every byte so that usart_baudrate can wait for
+ * the end of the transmission. */
+#define USART_SEND(usart,c) do { (usart)->module->STATUS = USART_TXCIF_bm; (usart)->module->DATA = (c); (usart)->sent = 1; } while (0)
+#define USART_DRE_ENABLE(usart) ((usart)->module->CTRLA = ((usart)->module->CTRLA & ~USART_DREINTLVL_gm) | USART_DREINTLVL_LO_gc)
+#define USART_DRE_DISABLE(usart) ((usart)->module->CTRLA &= ~USART_DREINTLVL_gm)
 
 #ifndef F_CPU
 #error "uart.c requires F_CPU to be defined"
 #endif
 
-void usart_init(void)
+#define USART_BUFFER_SIZES(RX,TX) (((RX) & ((RX)-1)) || ((TX) & ((TX)-1)) || (RX) > 256 || (TX) > 256)
+
+#if USART_BUFFER_SIZES(USART_RX_BUFFER_SIZE,USART_TX_BUFFER_SIZE) || USART_BUFFER_SIZES(USART1_RX_BUFFER_SIZE,USART1_TX_BUFFER_SIZE)
+#error "USART buffer sizes must be powers of two up to 256"
+#endif
+
+#if USART_RTS_THRESHOLD >= USART_RX_BUFFER_SIZE
+#error "USART_RTS_THRESHOLD must be smaller than USART_RX_BUFFER_SIZE"
+#endif
+
+#ifndef USE_FREERTOS
+#define USART_SHARE_MASK (USART_SHARE_SIZE-1)
+
+#if USART_BUFFER_SIZES(USART_SHARE_SIZE,USART_SHARE_SIZE)
+#error "USART_SHARE_SIZE must be a power of two up to 256"
+#endif
+
+/* Handshake lines are active low. */
+#define USART_RTS_ASSERT(usart) ((usart)->port->OUTCLR = (usart)->rts_pin_bm)
+#define USART_RTS_DEASSERT(usart) ((usart)->port->OUTSET = (usart)->rts_pin_bm)
+#define USART_CTS_ASSERTED(usart) (!((usart)->port->IN & (usart)->cts_pin_bm))
+#define USART_RX_FILL(usart) (((usart)->rx_head-(usart)->rx_tail) & (usart)->rx_mask)
+
+static uint8_t usart0_rx_buffer[USART_RX_BUFFER_SIZE];
+static uint8_t usart0_tx_buffer[USART_TX_BUFFER_SIZE];
+static uint8_t usart1_rx_buffer[USART1_RX_BUFFER_SIZE];
+static uint8_t usart1_tx_buffer[USART1_TX_BUFFER_SIZE];
+
+/* Records in the shared buffer consist of a length byte followed by
+ * the data. */
+static uint8_t usart_share[USART_SHARE_SIZE];
+static volatile uint8_t usart_share_head;
+
+/* End of the record whose latency is measured on the console. */
+static uint8_t usart_latency_end;
+static volatile uint8_t usart_latency_armed;
+
+static void usart_latency_cancel(void)
+{
+	if (usart_latency_armed) latency_cancel();
+	usart_latency_armed = 0;
+}
+#endif
+
+usart_t usart0 = {
+	.module = &USB_USART_MODULE,
+	.port = &USB_USART_PORT,
+	.rx_pin_bm = USB_USART_RX_PIN_bm,
+	.tx_pin_bm = USB_USART_TX_PIN_bm,
+	.rts_pin_bm = USB_USART_RTS_PIN_bm,
+	.cts_pin_bm = USB_USART_CTS_PIN_bm,
+	.rx_chmux = USB_USART_RX_CHMUX,
+#ifndef USE_FREERTOS
+	.rx_buffer = usart0_rx_buffer,
+	.tx_buffer = usart0_tx_buffer,
+	.rx_mask = USART_RX_BUFFER_SIZE-1,
+	.tx_mask = USART_TX_BUFFER_SIZE-1,
+#endif
+};
+
+usart_t usart1 = {
+	.module = &AUX_USART_MODULE,
+	.port = &AUX_USART_PORT,
+	.rx_pin_bm = AUX_USART_RX_PIN_bm,
+	.tx_pin_bm = AUX_USART_TX_PIN_bm,
+	.rx_chmux = AUX_USART_RX_CHMUX,
+#ifndef USE_FREERTOS
+	.rx_buffer = usart1_rx_buffer,
+	.tx_buffer = usart1_tx_buffer,
+	.rx_mask = USART1_RX_BUFFER_SIZE-1,
+	.tx_mask = USART1_TX_BUFFER_SIZE-1,
+#endif
+};
+
+static usart_t * const usart_instances[] = { &usart0, &usart1 };
+
+#define USART_INSTANCES (sizeof(usart_instances)/sizeof(usart_instances[0]))
+
+static void usart_set(usart_t *usart, long baud, int bsel, int bscale, int clk2x)
+{
+	usart->baud = baud;
+	usart->module->BAUDCTRLA = bsel & USART_BSEL_gm;
+	usart->module->BAUDCTRLB = (bscale<<USART_BSCALE_gp) | ((bsel>>8) & ~USART_BSCALE_gm);
+	usart->module->CTRLB = (usart->module->CTRLB & ~USART_CLK2X_bm) | ((clk2x) ? USART_CLK2X_bm : 0);
+}
+
+/* Waits until all buffered data has left the transmitter. While CTS
+ * holds the transmission, the buffered data is left for the new baud
+ * rate instead of waiting for the peer. */
+static void usart_drain(usart_t *usart)
+{
+#ifndef USE_FREERTOS
+	while (!usart->tx_paused && (usart->tx_head != usart->tx_tail || usart->share_left));
+	while (!usart->tx_paused && usart->share && usart->share_tail != usart_share_head);
+#endif
+	while (!(usart->module->STATUS & USART_DREIF_bm));
+	if (usart->sent) while (!(usart->module->STATUS & USART_TXCIF_bm));
+}
+
+void usart_init(usart_t *usart)
 {
     int bsel, bscale, clk2x;
-	USART_PORT.DIRSET = USART_TX_PIN_bm;
-	USART_PORT.DIRCLR = USART_RX_PIN_bm;
-	USART_MODULE.CTRLC = ( USART_CMODE_ASYNCHRONOUS_gc | USART_CHSIZE_8BIT_gc | USART_PMODE_DISABLED_gc);
+	usart->port->DIRSET = usart->tx_pin_bm;
+	usart->port->DIRCLR = usart->rx_pin_bm;
+	usart->module->CTRLC = ( USART_CMODE_ASYNCHRONOUS_gc | USART_CHSIZE_8BIT_gc | USART_PMODE_DISABLED_gc);
 	usart_params(F_CPU,USART_STD_BAUDRATE,&bsel,&bscale,&clk2x);
-	USART_MODULE.BAUDCTRLA = bsel & USART_BSEL_gm;
-	USART_MODULE.BAUDCTRLB = (bscale<<USART_BSCALE_gp) | ((bsel>>8) & ~USART_BSCALE_gm);
-	USART_MODULE.CTRLB = (USART_RXEN_bm | USART_TXEN_bm | ((clk2x) ? USART_CLK2X_bm : 0));
+	usart->module->CTRLB = USART_RXEN_bm | USART_TXEN_bm;
+	usart_set(usart,USART_STD_BAUDRATE,bsel,bscale,clk2x);
 }
 
-int usart_receive(void)
+int usart_receive(usart_t *usart)
 {
-	if (!(USART_MODULE.STATUS & USART_RXCIF_bm)) return USART_NO_DATA;
-	return USART_ERROR_CODE | USART_MODULE.DATA;
+	if (!(usart->module->STATUS & USART_RXCIF_bm)) return USART_NO_DATA;
+	return USART_ERROR_CODE(usart) | usart->module->DATA;
 }
 
-int usart_transmit(char c)
+int usart_transmit(usart_t *usart, char c)
 {
-	if (!(USART_MODULE.STATUS & USART_DREIF_bm)) return USART_BUSY;
-	USART_MODULE.DATA = c;
+	if (!(usart->module->STATUS & USART_DREIF_bm)) return USART_BUSY;
+	USART_SEND(usart,c);
 	return USART_SUCCESS;
 }
 
 int usart_getc(FILE *stream)
 {
-	return usart_getchar();
+	return usart_getchar(USART_CONSOLE);
 }
 
-int usart_getchar(void)
+int usart_getchar(usart_t *usart)
 {
     char data;
-	while (!(USART_MODULE.STATUS & USART_RXCIF_bm));
-	data = USART_MODULE.DATA;
-	return USART_ERROR_CODE | (data=='\r') ? '\n' : data;
+	while (!(usart->module->STATUS & USART_RXCIF_bm));
+	data = usart->module->DATA;
+	return USART_ERROR_CODE(usart) | (data=='\r') ? '\n' : data;
 }
 
 int usart_putc(char c, FILE *stream)
 {
-	return usart_putchar(c);
+	return usart_putchar(USART_CONSOLE,c);
+}
+
+int usart_putchar(usart_t *usart, char c)
+{
+	if (c == '\n') usart_putchar(usart,'\r');
+	while (!(usart->module->STATUS & USART_DREIF_bm));
+	USART_SEND(usart,c);
+	return USART_SUCCESS;
+}
+
+int usart_puts(usart_t *usart, const char *s)
+{
+    while (*s) usart_putchar(usart,*s++);
+	return USART_SUCCESS;
 }
 
-int usart_putchar(char c)
+int usart_puts_P(usart_t *usart, const char *s)
 {
-	if (c == '\n') usart_putchar('\r');
-	while (!(USART_MODULE.STATUS & USART_DREIF_bm));
-	USART_MODULE.DATA = c;
+    while (pgm_read_byte(s)) usart_putchar(usart,pgm_read_byte(s++));
 	return USART_SUCCESS;
 }
 
-int usart_puts(const char *s)
+int usart_baudrate(usart_t *usart, long baud)
+{
+	int bsel, bscale, clk2x, error;
+	error = usart_params(F_CPU,baud,&bsel,&bscale,&clk2x);
+	if (bsel < 0) return USART_BAUD_INVALID;
+	usart_drain(usart);
+	usart_set(usart,baud,bsel,bscale,clk2x);
+	return error;
+}
+
+long usart_get_baudrate(usart_t *usart)
+{
+	return usart->baud;
+}
+
+/* Shift of the prescalers DIV1 to DIV1024. */
+static const uint8_t usart_autobaud_shift[USART_AUTOBAUD_PRESCALERS] = { 0, 1, 2, 3, 6, 8, 10 };
+
+/* The counter counts the edges of the receive pin and the timer
+ * captures the time at every overflow of the counter. Two spans in a
+ * row must agree, which rejects lost captures and pauses of the host.
+ * Returns the span in timer ticks or 0 on timeout. */
+static uint16_t usart_autobaud_span(uint8_t prescaler, uint16_t edges, uint32_t *wait)
+{
+	uint16_t time[3], span, delta;
+	uint8_t i = 0, shift = usart_autobaud_shift[prescaler];
+	USART_AUTOBAUD_TIMER.CTRLA = TC_CLKSEL_OFF_gc;
+	USART_AUTOBAUD_COUNTER.CTRLA = TC_CLKSEL_OFF_gc;
+	USART_AUTOBAUD_COUNTER.PER = edges-1;
+	USART_AUTOBAUD_COUNTER.CNT = 0;
+	USART_AUTOBAUD_TIMER.CNT = 0;
+	USART_AUTOBAUD_TIMER.INTFLAGS = TC0_CCAIF_bm | TC0_OVFIF_bm;
+	USART_AUTOBAUD_TIMER.CTRLA = TC_CLKSEL_DIV1_gc+prescaler;
+	USART_AUTOBAUD_COUNTER.CTRLA = TC_CLKSEL_EVCH0_gc;
+	while (*wait) {
+		/* Reading CCA clears CCAIF. */
+		if (USART_AUTOBAUD_TIMER.INTFLAGS & TC0_CCAIF_bm) {
+			time[i++] = USART_AUTOBAUD_TIMER.CCA;
+			if (i < 3) continue;
+			span = time[2]-time[1];
+			delta = time[1]-time[0];
+			delta = (delta > span) ? delta-span : span-delta;
+			if (span && delta <= 1+span/32) return span;
+			time[0] = time[1];
+			time[1] = time[2];
+			i = 2;
+		}
+		else if (USART_AUTOBAUD_TIMER.INTFLAGS & TC0_OVFIF_bm) {
+			USART_AUTOBAUD_TIMER.INTFLAGS = TC0_OVFIF_bm;
+			*wait = (*wait > (1UL<<shift)) ? *wait-(1UL<<shift) : 0;
+		}
+	}
+	return 0;
+}
+
+/* Receives USART_AUTOBAUD_CHECK sync characters at the new rate. A
+ * square wave of sync characters is received correctly whatever edge
+ * the receiver starts on. */
+static uint8_t usart_autobaud_check(usart_t *usart, uint32_t *wait)
+{
+	uint8_t count = 0, status, data;
+	USART_AUTOBAUD_TIMER.CTRLA = TC_CLKSEL_OFF_gc;
+	USART_AUTOBAUD_TIMER.CNT = 0;
+	USART_AUTOBAUD_TIMER.INTFLAGS = TC0_OVFIF_bm;
+	USART_AUTOBAUD_TIMER.CTRLA = TC_CLKSEL_DIV1_gc;
+	usart->module->CTRLB |= USART_RXEN_bm;
+	while (*wait && count < USART_AUTOBAUD_CHECK) {
+		status = usart->module->STATUS;
+		if (status & USART_RXCIF_bm) {
+			data = usart->module->DATA;
+			if ((status & USART_FERR_bm) || data != USART_AUTOBAUD_CHAR) break;
+			count++;
+		}
+		else if (USART_AUTOBAUD_TIMER.INTFLAGS & TC0_OVFIF_bm) {
+			USART_AUTOBAUD_TIMER.INTFLAGS = TC0_OVFIF_bm;
+			(*wait)--;
+		}
+	}
+	usart->module->CTRLB &= ~USART_RXEN_bm;
+	return count == USART_AUTOBAUD_CHECK;
+}
+
+/* baud = F_CPU*edges/cycles, split so that no product exceeds 32 bits. */
+long usart_autobaud(usart_t *usart, uint16_t timeout)
+{
+	uint32_t wait = (uint32_t)timeout*(F_CPU/1000)/65536+1, bit, count, cycles;
+	uint16_t span, edges;
+	uint8_t prescaler, ctrla = usart->module->CTRLA;
+	int bsel, bscale, clk2x;
+	long baud = 0, previous = usart->baud;
+	usart_drain(usart);
+	usart->module->CTRLB &= ~USART_RXEN_bm;
+	usart->module->CTRLA = ctrla & ~USART_RXCINTLVL_gm;
+	EVSYS.CH0MUX = usart->rx_chmux;
+	EVSYS.CH1MUX = USART_AUTOBAUD_COUNTER_OVF;
+	USART_AUTOBAUD_TIMER.CTRLB = TC_WGMODE_NORMAL_gc | TC0_CCAEN_bm;
+	USART_AUTOBAUD_TIMER.CTRLD = TC_EVACT_CAPT_gc | TC_EVSEL_CH1_gc;
+	USART_AUTOBAUD_TIMER.PER = 0xFFFF;
+	USART_AUTOBAUD_COUNTER.CTRLB = TC_WGMODE_NORMAL_gc;
+	while (wait && !baud) {
+		/* The coarse span selects the prescaler and the number of edges
+		 * for a span of about USART_AUTOBAUD_SPAN ticks. */
+		span = usart_autobaud_span(USART_AUTOBAUD_COARSE,USART_AUTOBAUD_EDGES,&wait);
+		bit = ((uint32_t)span<<usart_autobaud_shift[USART_AUTOBAUD_COARSE])/USART_AUTOBAUD_EDGES;
+		if (!bit) continue;
+		for (prescaler=0;prescaler<USART_AUTOBAUD_PRESCALERS-1;prescaler++) {
+			if ((USART_AUTOBAUD_EDGES*bit>>usart_autobaud_shift[prescaler]) <= USART_AUTOBAUD_SPAN) break;
+		}
+		count = ((uint32_t)USART_AUTOBAUD_SPAN<<usart_autobaud_shift[prescaler])/bit;
+		edges = (count < USART_AUTOBAUD_EDGES) ? USART_AUTOBAUD_EDGES : count;
+		span = usart_autobaud_span(prescaler,edges,&wait);
+		if (!span) continue;
+		cycles = (uint32_t)span<<usart_autobaud_shift[prescaler];
+		baud = (F_CPU/cycles)*edges+((F_CPU%cycles)*edges+cycles/2)/cycles;
+		usart_params(F_CPU,baud,&bsel,&bscale,&clk2x);
+		if (bsel < 0) {
+			baud = 0;
+			continue;
+		}
+		usart_set(usart,baud,bsel,bscale,clk2x);
+		if (!usart_autobaud_check(usart,&wait)) baud = 0;
+	}
+	if (!baud) {
+		/* A rejected rate may be set, the previous one is restored. */
+		usart_params(F_CPU,previous,&bsel,&bscale,&clk2x);
+		usart_set(usart,previous,bsel,bscale,clk2x);
+	}
+	USART_AUTOBAUD_TIMER.CTRLA = TC_CLKSEL_OFF_gc;
+	USART_AUTOBAUD_COUNTER.CTRLA = TC_CLKSEL_OFF_gc;
+	USART_AUTOBAUD_TIMER.CTRLB = 0;
+	USART_AUTOBAUD_TIMER.CTRLD = 0;
+	EVSYS.CH0MUX = 0;
+	EVSYS.CH1MUX = 0;
+#ifndef USE_FREERTOS
+	usart->rx_tail = usart->rx_head;
+#endif
+	usart->module->CTRLA = ctrla;
+	usart->module->CTRLB |= USART_RXEN_bm;
+	return baud;
+}
+
+#ifndef USE_FREERTOS
+static uint8_t usart_tx_pending(usart_t *usart)
+{
+	return usart->tx_head != usart->tx_tail || usart->share_left
+		|| (usart->share && usart->share_tail != usart_share_head);
+}
+
+static void usart_tx_resume(usart_t *usart)
+{
+	usart->port->INTCTRL &= ~PORT_INT0LVL_gm;
+	usart->tx_paused = 0;
+	if (usart_tx_pending(usart)) USART_DRE_ENABLE(usart);
+}
+
+/* Stops the transmit interrupt until CTS is asserted. A falling edge
+ * between the check of CTS and the enabling of the pin change interrupt
+ * is caught by checking CTS again. */
+static void usart_tx_pause(usart_t *usart)
+{
+	USART_DRE_DISABLE(usart);
+	usart->tx_paused = 1;
+	usart->port->INTFLAGS = PORT_INT0IF_bm;
+	usart->port->INTCTRL = (usart->port->INTCTRL & ~PORT_INT0LVL_gm) | PORT_INT0LVL_LO_gc;
+	if (USART_CTS_ASSERTED(usart)) usart_tx_resume(usart);
+}
+
+void usart_buffer_init(usart_t *usart)
+{
+	usart->rx_head = usart->rx_tail = 0;
+	usart->tx_head = usart->tx_tail = 0;
+	usart->tx_commit = usart->tx_later = usart->tx_open = 0;
+	usart->rts_threshold = 0;
+	usart->tx_paused = 0;
+	usart->share = 0;
+	usart->share_left = 0;
+	usart->share_skipped = 0;
+	usart->module->CTRLA = USART_RXCINTLVL_LO_gc;
+}
+
+int usart_buffer_receive(usart_t *usart)
 {
-    while (*s) usart_putchar(*s++);
+	uint8_t data;
+	if (usart->rx_head == usart->rx_tail) return USART_NO_DATA;
+	data = usart->rx_buffer[usart->rx_tail];
+	usart->rx_tail = (usart->rx_tail+1) & usart->rx_mask;
+	/* A byte received in between deasserts RTS again in the ISR. */
+	if (usart->rts_threshold && USART_RX_FILL(usart) < usart->rts_threshold) USART_RTS_ASSERT(usart);
+	return data;
+}
+
+int usart_buffer_transmit(usart_t *usart, char c)
+{
+	uint8_t head = (usart->tx_head+1) & usart->tx_mask;
+	if (head == usart->tx_tail) return USART_BUSY;
+	usart->tx_buffer[usart->tx_head] = c;
+	usart->tx_head = head;
+	if (!usart->tx_paused) USART_DRE_ENABLE(usart);
 	return USART_SUCCESS;
 }
 
-int usart_puts_P(const char *s)
+/* Waits while the buffer is full, but not for a peer which holds CTS
+ * deasserted. Then the rest of the data is dropped. */
+static int usart_buffer_put(usart_t *usart, char c)
 {
-    while (pgm_read_byte(s)) usart_putchar(pgm_read_byte(s++));
+	while (usart_buffer_transmit(usart,c) != USART_SUCCESS) {
+		if (usart->tx_paused) return USART_BUSY;
+	}
 	return USART_SUCCESS;
 }
 
-int usart_bsel(long freq, long baud, int bscale, int clk2x)
+int usart_buffer_write(usart_t *usart, const uint8_t *data, uint8_t length)
+{
+	int result = USART_SUCCESS;
+	while (length-- && (result = usart_buffer_put(usart,*data)) == USART_SUCCESS) data++;
+	usart_buffer_commit(usart);
+	return result;
+}
+
+/* Counts the bytes instead of storing the index of the boundary, so
+ * that it cannot be mistaken after the ring buffer has wrapped. Only
+ * the next and the last boundary are kept, the ones in between are
+ * merged. */
+void usart_buffer_commit(usart_t *usart)
 {
-	long num, denom;
-	if (clk2x==0 && bscale>=0) {
-		num = (freq/10)-(16*baud*(1<<bscale)/10);
-		denom = 16*baud*(1<<bscale)/100;
+	uint8_t sreg = SREG, fill;
+	cli();
+	fill = (usart->tx_head-usart->tx_tail) & usart->tx_mask;
+	if (!fill) {
+		usart->tx_open = 0;
+		usart->tx_commit = usart->tx_later = 0;
+	}
+	else if (!usart->tx_commit) {
+		usart->tx_commit = fill;
 	}
-	else if (clk2x==0 && bscale<0) {
-		num = (1<<-bscale)*(freq/10-16*baud/10);
-		denom = 16*baud/100;
+	else {
+		usart->tx_later = fill-usart->tx_commit;
+	}
+	SREG = sreg;
+}
+
+int usart_buffer_getc(FILE *stream)
+{
+	int data;
+	while ((data = usart_buffer_receive(USART_CONSOLE)) == USART_NO_DATA);
+	return (data=='\r') ? '\n' : data;
+}
+
+int usart_buffer_putc(char c, FILE *stream)
+{
+	int result = USART_SUCCESS;
+	if (c == '\n') result = usart_buffer_put(USART_CONSOLE,'\r');
+	if (result == USART_SUCCESS) result = usart_buffer_put(USART_CONSOLE,c);
+	if (c == '\n') usart_buffer_commit(USART_CONSOLE);
+	return (result == USART_SUCCESS) ? 0 : EOF;
+}
+
+uint8_t usart_buffer_flow(usart_t *usart, uint8_t threshold)
+{
+	uint8_t sreg;
+	if (threshold > usart->rx_mask || (threshold && !usart->rts_pin_bm)) return 0;
+	sreg = SREG;
+	cli();
+	usart->rts_threshold = threshold;
+	if (threshold) {
+		if (USART_RX_FILL(usart) < threshold) USART_RTS_ASSERT(usart);
+		else USART_RTS_DEASSERT(usart);
+		usart->port->DIRSET = usart->rts_pin_bm;
+		usart->port->DIRCLR = usart->cts_pin_bm;
+		PORTCFG.MPCMASK = usart->cts_pin_bm;
+		usart->port->PIN0CTRL = PORT_OPC_PULLUP_gc | PORT_ISC_FALLING_gc;
+		usart->port->INT0MASK = usart->cts_pin_bm;
 	}
-	else if (clk2x==1 && bscale>=0) {
-		num = (freq/10)-(8*baud*(1<<bscale)/10);
-		denom = 8*baud*(1<<bscale)/100;
+	else if (usart->rts_pin_bm) {
+		usart->port->DIRCLR = usart->rts_pin_bm;
+		usart_tx_resume(usart);
 	}
-	else if (clk2x==1 && bscale<0) {
-		num = (1<<-bscale)*(freq/10-8*baud/10);
-		denom = 8*baud/100;
+	SREG = sreg;
+	return 1;
+}
+
+uint8_t usart_buffer_get_flow(usart_t *usart)
+{
+	return usart->rts_threshold;
+}
+
+void usart_share_attach(usart_t *usart, uint8_t attach)
+{
+	uint8_t sreg = SREG;
+	cli();
+	if (usart == USART_CONSOLE) usart_latency_cancel();
+	usart->share_tail = usart_share_head;
+	usart->share_left = 0;
+	usart->share = attach;
+	SREG = sreg;
+}
+
+/* Moves the cursor past the oldest records until length+1 bytes are
+ * free. A record in transmission which blocks the space is cut for this
+ * instance only, which then continues with the next record. */
+static void usart_share_skip(usart_t *usart, uint8_t length)
+{
+	uint8_t head = usart_share_head;
+	while (((usart->share_tail-head-1) & USART_SHARE_MASK) <= length) {
+		if (usart == USART_CONSOLE) usart_latency_cancel();
+		if (usart->share_left) {
+			usart->share_tail = (usart->share_tail+usart->share_left) & USART_SHARE_MASK;
+			usart->share_left = 0;
+		}
+		else {
+			usart->share_tail = (usart->share_tail+usart_share[usart->share_tail]+1) & USART_SHARE_MASK;
+		}
+		usart->share_skipped++;
 	}
-	#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
-	return (num<0 || denom==0) ? -1 : (num/denom+5)/10;
-	#pragma GCC diagnostic warning "-Wmaybe-uninitialized"
 }
 
-long usart_baud(long freq, int bsel, int bscale, int clk2x)
+uint8_t usart_share_write(const uint8_t *data, uint8_t length)
 {
-	long num, denom;
-	if (clk2x==0 && bscale>=0) {
-		num = freq/(1<<bscale)*10;
-		denom = 16*(bsel+1);
+	uint8_t head = usart_share_head, i, sreg;
+	usart_t *usart;
+	if (length == 0 || length > USART_SHARE_SIZE-2) return 0;
+	sreg = SREG;
+	cli();
+	for (i=0;i<USART_INSTANCES;i++) {
+		usart = usart_instances[i];
+		if (usart->share) usart_share_skip(usart,length);
+	}
+	SREG = sreg;
+	usart_share[head] = length;
+	while (length--) {
+		head = (head+1) & USART_SHARE_MASK;
+		usart_share[head] = *data++;
 	}
-	else if (clk2x==0 && bscale<0) {
-		num = freq/16*(1<<-bscale)*10;
-		denom = bsel+(1<<-bscale);
+	usart_share_head = (head+1) & USART_SHARE_MASK;
+	for (i=0;i<USART_INSTANCES;i++) {
+		usart = usart_instances[i];
+		if (usart->share && !usart->tx_paused) USART_DRE_ENABLE(usart);
 	}
-	else if (clk2x==1 && bscale>=0) {
-		num = freq/(1<<bscale)*10;
-		denom = 8*(bsel+1);
+	return 1;
+}
+
+void usart_share_latency(uint16_t stamp)
+{
+	uint8_t sreg = SREG;
+	cli();
+	if (USART_CONSOLE->share) {
+		usart_latency_end = usart_share_head;
+		usart_latency_armed = latency_start(stamp);
 	}
-	else if (clk2x==1 && bscale<0) {
-		num = freq/8*(1<<-bscale)*10;
-		denom = bsel+(1<<-bscale);
+	SREG = sreg;
+}
+
+static void usart_rxc(usart_t *usart)
+{
+	uint8_t data = usart->module->DATA;
+	uint8_t head = (usart->rx_head+1) & usart->rx_mask;
+	if (head != usart->rx_tail) {
+		usart->rx_buffer[usart->rx_head] = data;
+		usart->rx_head = head;
 	}
-	#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
-	return (num<0 || denom==0) ? -1 : (num/denom+5)/10;
-	#pragma GCC diagnostic warning "-Wmaybe-uninitialized"
+	if (usart->rts_threshold && USART_RX_FILL(usart) >= usart->rts_threshold) USART_RTS_DEASSERT(usart);
 }
 
-int usart_params(long freq, long baud, int* bsel, int* bscale, int* clk2x)
+/* A record of the shared buffer is only started at a boundary of the
+ * private buffer and then sent completely. */
+static void usart_dre(usart_t *usart)
 {
-	int error;
-	if (baud > freq/16) {
-		*bsel = -1;
-		return 1000;
+	uint8_t tail;
+	if (usart->rts_threshold && !USART_CTS_ASSERTED(usart)) {
+		usart_tx_pause(usart);
+		return;
+	}
+	if (!usart->share_left && usart->share && !usart->tx_open && usart->share_tail != usart_share_head) {
+		tail = usart->share_tail;
+		usart->share_left = usart_share[tail];
+		usart->share_tail = (tail+1) & USART_SHARE_MASK;
 	}
-	for (*clk2x=1;*clk2x>=0;(*clk2x)--) {
-		for (*bscale=-7;*bscale<8;(*bscale)++) {
-			*bsel = usart_bsel(freq,baud,*bscale,*clk2x);
-			if (-1<*bsel && *bsel<LIMIT) goto found;
+	if (usart->share_left) {
+		tail = usart->share_tail;
+		USART_SEND(usart,usart_share[tail]);
+		usart->share_tail = (tail+1) & USART_SHARE_MASK;
+		usart->share_left--;
+		if (usart == USART_CONSOLE && usart_latency_armed && !usart->share_left && usart->share_tail == usart_latency_end) {
+			latency_stop();
+			usart_latency_armed = 0;
 		}
 	}
-	found:
-	error = 1000*(usart_baud(freq,*bsel,*bscale,*clk2x)-baud)/baud;
-	*bsel = (*bsel>LIMIT || error>USART_BAUD_TOLERANCE) ? -1 : *bsel;
-	return error;
+	else if (usart->tx_tail != usart->tx_head) {
+		tail = usart->tx_tail;
+		USART_SEND(usart,usart->tx_buffer[tail]);
+		usart->tx_tail = (tail+1) & usart->tx_mask;
+		usart->tx_open = 1;
+		if (usart->tx_commit && !--usart->tx_commit) {
+			usart->tx_open = 0;
+			usart->tx_commit = usart->tx_later;
+			usart->tx_later = 0;
+		}
+	}
+	else {
+		USART_DRE_DISABLE(usart);
+	}
+}
+
+ISR(USB_USART_RXC_vect)
+{
+	TRACE_ENTER(TRACE_RXC_ISR);
+	usart_rxc(&usart0);
+	TRACE_LEAVE(TRACE_RXC_ISR);
+}
+
+ISR(USB_USART_DRE_vect)
+{
+	TRACE_ENTER(TRACE_DRE_ISR);
+	usart_dre(&usart0);
+	TRACE_LEAVE(TRACE_DRE_ISR);
+}
+
+ISR(USB_USART_CTS_vect)
+{
+	if (USART_CTS_ASSERTED(&usart0)) usart_tx_resume(&usart0);
+}
+
+ISR(AUX_USART_RXC_vect)
+{
+	usart_rxc(&usart1);
+}
+
+ISR(AUX_USART_DRE_vect)
+{
+	usart_dre(&usart1);
+}
+#else
+static uint8_t usart_rx_storage[USART_RX_STREAM_SIZE+1];
+static uint8_t usart_tx_storage[USART_TX_STREAM_SIZE+1];
+static StaticStreamBuffer_t usart_rx_buffer;
+static StaticStreamBuffer_t usart_tx_buffer;
+static StreamBufferHandle_t usart_rx_stream;
+static StreamBufferHandle_t usart_tx_stream;
+
+/* Bytes written into and sent from the transmit stream buffer, used to
+ * find the last byte of the output whose latency is measured. */
+static uint16_t usart_stream_queued;
+static volatile uint16_t usart_stream_sent;
+static volatile uint16_t usart_latency_end;
+static volatile uint8_t usart_latency_armed;
+
+void usart_stream_init(void)
+{
+	usart_rx_stream = xStreamBufferCreateStatic(sizeof(usart_rx_storage),1,usart_rx_storage,&usart_rx_buffer);
+	usart_tx_stream = xStreamBufferCreateStatic(sizeof(usart_tx_storage),1,usart_tx_storage,&usart_tx_buffer);
+	USART_CONSOLE->module->CTRLA = USART_RXCINTLVL_LO_gc;
 }
+
+int usart_stream_getc(FILE *stream)
+{
+	char data;
+	xStreamBufferReceive(usart_rx_stream,&data,1,portMAX_DELAY);
+	return (data=='\r') ? '\n' : data;
+}
+
+int usart_stream_putc(char c, FILE *stream)
+{
+	if (c == '\n') usart_stream_putc('\r',stream);
+	xStreamBufferSend(usart_tx_stream,&c,1,portMAX_DELAY);
+	usart_stream_queued++;
+	USART_DRE_ENABLE(USART_CONSOLE);
+	return USART_SUCCESS;
+}
+
+void usart_stream_latency(uint16_t stamp)
+{
+	taskENTER_CRITICAL();
+	usart_latency_end = usart_stream_queued;
+	usart_latency_armed = (usart_stream_sent != usart_stream_queued) && latency_start(stamp);
+	taskEXIT_CRITICAL();
+}
+
+ISR(USB_USART_RXC_vect)
+{
+	BaseType_t woken = pdFALSE;
+	char data = usart0.module->DATA;
+	xStreamBufferSendFromISR(usart_rx_stream,&data,1,&woken);
+	portYIELD_FROM_ISR(woken);
+}
+
+ISR(USB_USART_DRE_vect)
+{
+	BaseType_t woken = pdFALSE;
+	char data;
+	if (xStreamBufferReceiveFromISR(usart_tx_stream,&data,1,&woken)) {
+		USART_SEND(&usart0,data);
+		if (++usart_stream_sent == usart_latency_end && usart_latency_armed) {
+			latency_stop();
+			usart_latency_armed = 0;
+		}
+	}
+	else {
+		USART_DRE_DISABLE(&usart0);
+	}
+	portYIELD_FROM_ISR(woken);
+}
+#endif
@@ -2,31 +2,45 @@
 *
 * \brief This module implements an RS-232 based serial communication.
 *
+* Every USART is described by an instance of <c>usart_t</c> which is
+* passed to all functions. usart0 is connected with the USB gateway and
+* used as console, usart1 is available on jumper J4 (PC6 RXD, PC7 TXD).
+*
+* In buffered operation, records such as encoded key events can be
+* written once into a shared buffer with <c>usart_share_write</c>. Every
+* attached instance transmits them from there with its own read
+* cursor. A slow instance does not block the others: if it falls
+* behind by more than the size of the shared buffer, its oldest records
+* are skipped. A record which is being transmitted and blocks the space
+* is cut for the slow instance only; the others still get the new
+* record. The transmit
+* interrupt switches between the private transmit buffer and the shared
+* buffer only at the end of a record and at the boundaries set by the
+* writer of the private buffer: the end of a line, of data written with
+* <c>usart_buffer_write</c> or <c>usart_buffer_commit</c>.
+*
 * \author    Wolfgang Neff
-* \version   1.2
-* \date      2015-01-28
+* \version   1.4
+* \date      2026-10-19
 *
 * \par History
 *      Created: 2012-09-03 \n
 *      Modified: 2014-10-17 \n
-*      Modified: 2015-01-28
+*      Modified: 2015-01-28 \n
+*      Modified: 2026-10-19
 */
 
 #ifndef USART_H_
 #define USART_H_
 
 #include <stdio.h>
+#include <stdint.h>
+#include <avr/io.h>
+#include "baud.h"
 
 #define USART_STD_BAUDRATE 115200
 
-#define USART_PORT USB_USART_PORT
-#define USART_MODULE USB_USART_MODULE
-#define USART_RX_PIN_bp USB_USART_RX_PIN_bp
-#define USART_RX_PIN_bm USB_USART_RX_PIN_bm
-#define USART_TX_PIN_bp USB_USART_TX_PIN_bp
-#define USART_TX_PIN_bm USB_USART_TX_PIN_bm
-#define USART_RXC_vect USB_USART_RXC_vect
-#define USART_DRE_vect USB_USART_DRE_vect
+#define USART_CONSOLE (&usart0)
 
 #define USART_FRAME_ERROR   0x0400    /* Framing Error by USART     */
 #define USART_OVERRUN_ERROR 0x0200    /* Overrun condition by USART */
@@ -36,8 +50,80 @@
 #define USART_SUCCESS       0x0000    /* Operation succeeded        */
 #define USART_ERROR(code) (code & 0xFF00)
 
-#define USART_BSEL_BITS 12
-#define USART_BAUD_TOLERANCE 20
+/* Shared with the capture module, both use it only while blocking. */
+#define USART_AUTOBAUD_TIMER TCD0
+#define USART_AUTOBAUD_COUNTER TCE1
+#define USART_AUTOBAUD_COUNTER_OVF EVSYS_CHMUX_TCE1_OVF_gc
+#define USART_AUTOBAUD_CHAR 'U'
+#define USART_AUTOBAUD_EDGES 16
+#define USART_AUTOBAUD_SPAN 16384
+#define USART_AUTOBAUD_CHECK 4
+#define USART_AUTOBAUD_PRESCALERS 7
+#define USART_AUTOBAUD_COARSE 4
+
+#ifndef USART_RX_BUFFER_SIZE
+#define USART_RX_BUFFER_SIZE 32
+#endif
+#ifndef USART_TX_BUFFER_SIZE
+#define USART_TX_BUFFER_SIZE 128
+#endif
+#ifndef USART_RTS_THRESHOLD
+#define USART_RTS_THRESHOLD (USART_RX_BUFFER_SIZE-8)
+#endif
+#ifndef USART1_RX_BUFFER_SIZE
+#define USART1_RX_BUFFER_SIZE 8
+#endif
+#ifndef USART1_TX_BUFFER_SIZE
+#define USART1_TX_BUFFER_SIZE 16
+#endif
+#ifndef USART_SHARE_SIZE
+#define USART_SHARE_SIZE 128
+#endif
+
+#ifndef USART_RX_STREAM_SIZE
+#define USART_RX_STREAM_SIZE 32
+#endif
+#ifndef USART_TX_STREAM_SIZE
+#define USART_TX_STREAM_SIZE 64
+#endif
+
+/// <summary>A USART instance.</summary>
+/// <remarks>
+/// The first part describes the hardware and the buffers and is set up
+/// by the definition of the instance. The rest is the state of the
+/// driver.
+/// </remarks>
+typedef struct {
+	USART_t *module;                  ///< The USART module.
+	PORT_t *port;                     ///< The port of the pins.
+	uint8_t rx_pin_bm;                ///< The receive pin.
+	uint8_t tx_pin_bm;                ///< The transmit pin.
+	uint8_t rts_pin_bm;               ///< The RTS pin or 0 if there is none.
+	uint8_t cts_pin_bm;               ///< The CTS pin or 0 if there is none.
+	uint8_t rx_chmux;                 ///< Event channel input of the receive pin.
+	uint8_t *rx_buffer;               ///< The receive ring buffer.
+	uint8_t *tx_buffer;               ///< The transmit ring buffer.
+	uint8_t rx_mask;                  ///< Size of the receive buffer minus one.
+	uint8_t tx_mask;                  ///< Size of the transmit buffer minus one.
+	long baud;                        ///< The baud rate.
+	volatile uint8_t sent;            ///< A byte has been transmitted.
+	volatile uint8_t rx_head;         ///< Write index of the receive buffer.
+	volatile uint8_t rx_tail;         ///< Read index of the receive buffer.
+	volatile uint8_t tx_head;         ///< Write index of the transmit buffer.
+	volatile uint8_t tx_tail;         ///< Read index of the transmit buffer.
+	volatile uint8_t tx_commit;       ///< Bytes up to the next boundary set by the writer.
+	volatile uint8_t tx_later;        ///< Bytes from the next to the last boundary.
+	volatile uint8_t tx_open;         ///< Transmission is not at a boundary.
+	volatile uint8_t tx_paused;       ///< Transmission stopped by CTS.
+	volatile uint8_t rts_threshold;   ///< Flow control threshold or 0.
+	volatile uint8_t share;           ///< Attached to the shared buffer.
+	volatile uint8_t share_tail;      ///< Read index of the shared buffer.
+	volatile uint8_t share_left;      ///< Bytes left of the current record.
+	volatile uint16_t share_skipped;  ///< Records skipped or cut because of overruns.
+} usart_t;
+
+extern usart_t usart0;
+extern usart_t usart1;
 
 #ifdef __cplusplus
 extern "C"
@@ -49,7 +135,8 @@ extern "C"
 	/// Initializes the USART port for a serial communication via the RS-232
 	/// protocol with the given standard baud rate and parameter 8N1.
 	/// </remarks>
-	void usart_init(void);
+	/// <param name="usart">The USART.</param>
+	void usart_init(usart_t *usart);
 
 	/* Asynchronous functions */
 
@@ -60,7 +147,7 @@ extern "C"
 	/// returned.
 	/// </remarks>
 	/// </example><code>
-	/// int data = usart_receive();
+	/// int data = usart_receive(USART_CONSOLE);
 	/// if (data != USART_NO_DATA) {
 	///     uint8_t byte = data;
 	///     int status = USART_ERROR(data);
@@ -69,8 +156,9 @@ extern "C"
 	///     }
 	/// }
 	/// </code></example>
+	/// <param name="usart">The USART.</param>
 	/// <returns>Received data or USART_NO_DATA if there is none.</returns>
-	int usart_receive(void);
+	int usart_receive(usart_t *usart);
 
 	/// <summary>Transmit asynchronously a byte.</summary>
 	/// <remarks>
@@ -78,10 +166,11 @@ extern "C"
 	/// transmited and USART_SUCCESS is returned. If no, USART_BUSY is
 	/// returned.
 	/// </remarks>
+	/// <param name="usart">The USART.</param>
 	/// <returns>
 	/// USART_SUCCESS if the data has been transmitted or USART_BUSY otherwise.
 	/// </returns>
-	int usart_transmit(char c);
+	int usart_transmit(usart_t *usart, char c);
 
 	/* Synchronous functions */
 
@@ -90,12 +179,14 @@ extern "C"
 	/// Waits until a byte has been received. Then returns the bye together
 	/// with a possible error code.
 	/// </remarks>
+	/// <param name="usart">The USART.</param>
 	/// <returns>Received data.</returns>
-	int usart_getchar(void);
+	int usart_getchar(usart_t *usart);
 
 	/// <summary>Receive synchronously a byte.</summary>
 	/// <remarks>
-	/// Same as <c>usart_getchar</c>. Used by <c>console</c> module.
+	/// Same as <c>usart_getchar</c> for USART_CONSOLE. Used by
+	/// <c>console</c> module.
 	/// </remarks>
 	/// <param name="stream">A dummy argument.</param>
 	/// <returns>Received data.</returns>
@@ -105,13 +196,15 @@ extern "C"
 	/// <remarks>
 	/// Waits until a byte has been transmited and returns USART_SUCCESS.
 	/// </remarks>
+	/// <param name="usart">The USART.</param>
 	/// <param name="c">The data to be transmitted.</param>
 	/// <returns>USART_SUCCESS after the data has been transmitted.</returns>
-	int usart_putchar(char c);
+	int usart_putchar(usart_t *usart, char c);
 
 	/// <summary>Transmit synchronously a byte.</summary>
 	/// <remarks>
-	/// Same as <c>usart_putchar</c>. Used by <c>console</c> module.
+	/// Same as <c>usart_putchar</c> for USART_CONSOLE. Used by
+	/// <c>console</c> module.
 	/// </remarks>
 	/// <param name="c">The data to be transmitted.</param>
 	/// <param name="stream">A dummy argument.</param>
@@ -119,9 +212,10 @@ extern "C"
 	int usart_putc(char c, FILE *stream);
 
 	/// <summary>Transmit synchronously a string.</summary>
+	/// <param name="usart">The USART.</param>
 	/// <param name="s">The string to be transmitted.</param>
 	/// <returns>USART_SUCCESS after the string has been transmitted.</returns>
-	int usart_puts(const char *s);
+	int usart_puts(usart_t *usart, const char *s);
 
 	/// <summary>Transmit synchronously a string.</summary>
 	/// <remarks>
@@ -130,56 +224,233 @@ extern "C"
 	/// </example><code>
 	/// #include <avr/pgmspace.h>
 	/// const char message1[] PROGMEM = "This is message one.\n"
-	/// usart_puts_P(message1);
-	/// usart_puts_P(PSTR("This is message two.\n"));
+	/// usart_puts_P(USART_CONSOLE,message1);
+	/// usart_puts_P(USART_CONSOLE,PSTR("This is message two.\n"));
 	/// </code></example>
+	/// <param name="usart">The USART.</param>
 	/// <param name="s">The string to be transmitted.</param>
 	/// <returns>USART_SUCCESS after the string has been transmitted.</returns>
-	int usart_puts_P(const char *s);
+	int usart_puts_P(usart_t *usart, const char *s);
+
+	/// <summary>Change the baud rate.</summary>
+	/// <remarks>
+	/// Waits until all buffered data has been transmitted and programs
+	/// the baud rate registers with the values found by
+	/// <c>usart_params</c>. The baud rate is kept if no valid values
+	/// can be found.
+	/// </remarks>
+	/// <param name="usart">The USART.</param>
+	/// <param name="baud">The new baud rate.</param>
+	/// <returns>
+	/// The deviation of the resulting baud rate in per mill or
+	/// USART_BAUD_INVALID if the baud rate has not been changed.
+	/// </returns>
+	int usart_baudrate(usart_t *usart, long baud);
 
-	/* Auxiliary functions */
+	/// <summary>Read the baud rate.</summary>
+	/// <param name="usart">The USART.</param>
+	/// <returns>The baud rate set by <c>usart_init</c>, <c>usart_baudrate</c> or <c>usart_autobaud</c>.</returns>
+	long usart_get_baudrate(usart_t *usart);
 
-	/// <summary>Calculate BSEL.</summary>
+	/// <summary>Detect the baud rate of the host.</summary>
 	/// <remarks>
-	/// Calculates the corresponding value for BSEL for a given F_CPU, baud
-	/// rate, BSCALE and clock rate.
+	/// Waits until all buffered data has been transmitted and disables
+	/// the receiver. The host sends USART_AUTOBAUD_CHAR ('U') back to
+	/// back, which is a square wave with an edge after every bit. The
+	/// receive pin clocks USART_AUTOBAUD_COUNTER through event channel 0
+	/// and every overflow of the counter captures the time with
+	/// USART_AUTOBAUD_TIMER through event channel 1, so the edges are
+	/// counted by the hardware and interrupts stay enabled.
+	///
+	/// A coarse measurement of USART_AUTOBAUD_EDGES edges selects the
+	/// prescaler of the timer and the number of edges for a span of
+	/// about USART_AUTOBAUD_SPAN ticks, which gives a resolution of
+	/// better than 0.01 % at any F_CPU, including 2 MHz. The rate is
+	/// programmed and accepted after USART_AUTOBAUD_CHECK sync characters
+	/// have been received without error; otherwise it is measured again.
+	/// The receive interrupt is disabled meanwhile and the received sync
+	/// characters are discarded. The host should send a newline once it
+	/// has received the answer at the new rate.
 	/// </remarks>
-	/// <param name="freq">The given value of F_CPU.</param>
-	/// <param name="baud">The desired baud rate.</param>
-	/// <param name="bscale">The desired value for BSCALE.</param>
-	/// <param name="clk2x">Indicates if clock rate should be doubled.</param>
-	/// <returns>The value of BESL to get the desired baud rate.</returns>
-	int usart_bsel(long freq, long baud, int bscale, int clk2x);
+	/// <param name="usart">The USART.</param>
+	/// <param name="timeout">Time to wait in milliseconds.</param>
+	/// <returns>
+	/// The measured baud rate which has been programmed, or 0 if the
+	/// timeout expired or no valid parameters can be found. Then the
+	/// previous baud rate is restored.
+	/// </returns>
+	long usart_autobaud(usart_t *usart, uint16_t timeout);
 
-	/// <summary>Calculate baud rate.</summary>
+	#ifndef USE_FREERTOS
+	/* Buffered functions */
+
+	/// <summary>Initialize buffered operation.</summary>
 	/// <remarks>
-	/// Calculates the resulting baud rate for a given F_CPU, BSEL, BSCALE and
-	/// clock rate.
+	/// Enables the receive interrupt. Received bytes and bytes to be
+	/// transmitted are stored in the ring buffers of the instance
+	/// (USART_RX_BUFFER_SIZE and USART_TX_BUFFER_SIZE bytes for usart0).
+	/// Must be called after <c>usart_init</c>. Low level interrupts must
+	/// be enabled by the caller.
 	/// </remarks>
-	/// <param name="freq">The given value of F_CPU.</param>
-	/// <param name="bsel">The given value of BSEL.</param>
-	/// <param name="bscale">The given value of BSCALE.</param>
-	/// <param name="clk2x">Indicates if clock rate should be doubled.</param>
-	/// <returns>The resulting baud rate for the given parameters.</returns>
-	long usart_baud(long freq, int bsel, int bscale, int clk2x);
+	/// <param name="usart">The USART.</param>
+	void usart_buffer_init(usart_t *usart);
+
+	/// <summary>Receive a byte from the buffer.</summary>
+	/// <param name="usart">The USART.</param>
+	/// <returns>Received data or USART_NO_DATA if there is none.</returns>
+	int usart_buffer_receive(usart_t *usart);
+
+	/// <summary>Put a byte into the transmit buffer.</summary>
+	/// <param name="usart">The USART.</param>
+	/// <param name="c">The data to be transmitted.</param>
+	/// <returns>
+	/// USART_SUCCESS if the data has been buffered or USART_BUSY if the
+	/// buffer is full.
+	/// </returns>
+	int usart_buffer_transmit(usart_t *usart, char c);
 
-	/// <summary>Calculate BSEL, BSCALE and clock rate.</summary>
+	/// <summary>Put data into the transmit buffer.</summary>
 	/// <remarks>
-	/// Determines the the best values for BSEL, BSCALE and CLK2X for a given
-	/// F_CPU and baud rate. Sets BSEL to -1 if no valid value can be found
-	/// or if the resulting baud rate lies outside the given tolerance of
-	/// USART_BAUD_TOLERANCE which is specified in per mill.
+	/// Waits while the buffer is full. The data is transmitted unchanged
+	/// and not interrupted by records of the shared buffer. If the buffer
+	/// is full while CTS holds the transmission, the rest of the data is
+	/// dropped instead of blocking the caller.
 	/// </remarks>
-	/// <param name="freq">The given value of F_CPU.</param>
-	/// <param name="baud">The desired baud rate.</param>
-	/// <param name="bsel">The resulting value for BSEL.</param>
-	/// <param name="bscale">The resulting value for BSCALE.</param>
-	/// <param name="clk2x">The resulting value for CLK2X.</param>
+	/// <param name="usart">The USART.</param>
+	/// <param name="data">The data to be transmitted.</param>
+	/// <param name="length">The length of the data.</param>
 	/// <returns>
-	/// The deviation of resulting baud rate from the given baud rate
-	/// in per mill.
+	/// USART_SUCCESS after the data has been buffered or USART_BUSY if
+	/// data has been dropped.
 	/// </returns>
-	int usart_params(long freq, long baud, int* bsel, int* bscale, int* clk2x);
+	int usart_buffer_write(usart_t *usart, const uint8_t *data, uint8_t length);
+
+	/// <summary>Set a boundary in the transmit buffer.</summary>
+	/// <remarks>
+	/// Records of the shared buffer are only transmitted at boundaries of
+	/// the transmit buffer. <c>usart_buffer_putc</c> sets one after every
+	/// line and <c>usart_buffer_write</c> after the data. Output which is
+	/// not terminated by a newline, e.g. hex values, must set its
+	/// boundaries with this function.
+	/// </remarks>
+	/// <param name="usart">The USART.</param>
+	void usart_buffer_commit(usart_t *usart);
+
+	/// <summary>Receive a byte from the buffer.</summary>
+	/// <remarks>
+	/// Waits until a byte has been received by USART_CONSOLE. Used by
+	/// <c>console</c> module.
+	/// </remarks>
+	/// <param name="stream">A dummy argument.</param>
+	/// <returns>Received data.</returns>
+	int usart_buffer_getc(FILE *stream);
+
+	/// <summary>Put a byte into the transmit buffer.</summary>
+	/// <remarks>
+	/// Waits while the buffer of USART_CONSOLE is full. If it is full
+	/// while CTS holds the transmission, the byte is dropped, so that the
+	/// output cannot block the main loop. Records of the shared buffer
+	/// are transmitted between complete lines. Used by <c>console</c>
+	/// module.
+	/// </remarks>
+	/// <param name="c">The data to be transmitted.</param>
+	/// <param name="stream">A dummy argument.</param>
+	/// <returns>0 after the data has been buffered or EOF if it has been dropped.</returns>
+	int usart_buffer_putc(char c, FILE *stream);
+
+	/// <summary>Configure hardware flow control.</summary>
+	/// <remarks>
+	/// With a threshold RTS is deasserted as soon as the receive buffer
+	/// holds threshold bytes and asserted again when it has been read
+	/// below. The threshold should leave room for the bytes the host
+	/// sends after RTS has been deasserted. The transmit interrupt stops
+	/// while CTS is deasserted and is resumed by a pin change interrupt
+	/// of CTS. Zero disables flow control and releases RTS. The default
+	/// threshold is USART_RTS_THRESHOLD.
+	/// </remarks>
+	/// <param name="usart">The USART.</param>
+	/// <param name="threshold">Fill level of the receive buffer or 0.</param>
+	/// <returns>1 if successful or 0 if the threshold is too large.</returns>
+	uint8_t usart_buffer_flow(usart_t *usart, uint8_t threshold);
+
+	/// <summary>Get the flow control threshold.</summary>
+	/// <param name="usart">The USART.</param>
+	/// <returns>The threshold or 0 if flow control is disabled.</returns>
+	uint8_t usart_buffer_get_flow(usart_t *usart);
+
+	/// <summary>Attach to the shared buffer.</summary>
+	/// <remarks>
+	/// An attached instance transmits all records which are written into
+	/// the shared buffer from now on.
+	/// </remarks>
+	/// <param name="usart">The USART.</param>
+	/// <param name="attach">1 to attach, 0 to detach.</param>
+	void usart_share_attach(usart_t *usart, uint8_t attach);
+
+	/// <summary>Write a record into the shared buffer.</summary>
+	/// <remarks>
+	/// The record is copied once and transmitted by every attached
+	/// instance. The function never waits: the cursors of instances which
+	/// lag behind are moved past their oldest records until the new
+	/// record fits. If an instance is in the middle of its oldest record,
+	/// that record is cut for this instance only, which continues with
+	/// the next record; the receiver discards the incomplete frame by its
+	/// checksum. Each skipped or cut record is counted once by the
+	/// instance which has lost it.
+	/// </remarks>
+	/// <param name="data">The record.</param>
+	/// <param name="length">The length from 1 to USART_SHARE_SIZE-2.</param>
+	/// <returns>1 if successful or 0 if the length is invalid.</returns>
+	uint8_t usart_share_write(const uint8_t *data, uint8_t length);
+
+	/// <summary>Measure the latency of the last record.</summary>
+	/// <remarks>
+	/// Starts a measurement with <c>latency_start</c> which is stopped
+	/// when USART_CONSOLE loads the last byte of the record written last.
+	/// The measurement is abandoned if the record is skipped.
+	/// </remarks>
+	/// <param name="stamp">The time stamp of the event, see latency.h.</param>
+	void usart_share_latency(uint16_t stamp);
+	#else
+	/* FreeRTOS stream buffer functions */
+
+	/// <summary>Initialize stream buffers.</summary>
+	/// <remarks>
+	/// Creates the receive and transmit stream buffers and enables the
+	/// receive interrupt. Must be called after <c>usart_init</c> and
+	/// before the scheduler is started. Each stream buffer supports only
+	/// one writing and one reading task.
+	/// </remarks>
+	void usart_stream_init(void);
+
+	/// <summary>Receive a byte from the stream buffer.</summary>
+	/// <remarks>
+	/// Blocks the calling task until a byte has been received. Used by
+	/// <c>console</c> module.
+	/// </remarks>
+	/// <param name="stream">A dummy argument.</param>
+	/// <returns>Received data.</returns>
+	int usart_stream_getc(FILE *stream);
+
+	/// <summary>Transmit a byte through the stream buffer.</summary>
+	/// <remarks>
+	/// Blocks the calling task while the stream buffer is full. Used by
+	/// <c>console</c> module.
+	/// </remarks>
+	/// <param name="c">The data to be transmitted.</param>
+	/// <param name="stream">A dummy argument.</param>
+	/// <returns>USART_SUCCESS after the data has been buffered.</returns>
+	int usart_stream_putc(char c, FILE *stream);
+
+	/// <summary>Measure the latency of the last output.</summary>
+	/// <remarks>
+	/// Starts a measurement with <c>latency_start</c> which is stopped
+	/// when the last byte written so far is loaded into the data register.
+	/// Must be called by the writing task.
+	/// </remarks>
+	/// <param name="stamp">The time stamp of the event, see latency.h.</param>
+	void usart_stream_latency(uint16_t stamp);
+	#endif
 
 	#ifdef __cplusplus
 }
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""Bounce duration statistics from raw keypad captures.
+
+Reads the output of the shell command "capture" from a file or a serial
+device, splits the transitions of every sense line into press and release
+events and reports the bounce duration (first to last transition of an
+event) per key. With -o the distributions are plotted with matplotlib.
+
+Version: 1.0
+Created: 2026-10-19
+ Author: Wolfgang Neff
+"""
+
+import argparse
+import statistics
+import sys
+
+import padlog
+
+KEY_NAMES = "*0#D789C456B123A"  # PAD_KEY_NAMES in pad.h
+FRAME_CAPTURE = ord('C')
+VALUE_GP = 12
+LENGTH_GM = 0x0FFF
+
+
+def parse(data):
+    """Yields (line, rate, runs) for every capture in the stream."""
+    for words, payloads in padlog.blocks(data, "capture", 2, FRAME_CAPTURE):
+        runs = [payload[k] | payload[k + 1] << 8
+                for payload in payloads for k in range(0, len(payload) - 1, 2)]
+        yield int(words[1]), int(words[2]), runs
+
+
+def transitions(runs):
+    """Returns the initial value and the sample index and value of every change."""
+    result, index, previous = [], 0, None
+    for run in runs:
+        value = run >> VALUE_GP
+        if value != previous:
+            result.append((index, value))
+        previous = value
+        index += (run & LENGTH_GM) + 1
+    return result
+
+
+def bounces(line, rate, runs, gap):
+    """Returns {(key, edge): [duration in ms]} for one capture."""
+    result = {}
+    changes = transitions(runs)
+    if not changes:
+        return result
+    for bit in range(4):
+        key = KEY_NAMES[(3 - line) * 4 + bit]
+        edges, previous = [], (changes[0][1] >> bit) & 1
+        for index, value in changes[1:]:
+            level = (value >> bit) & 1
+            if level != previous:
+                edges.append((index, level))
+                previous = level
+        events = []
+        for index, level in edges:
+            if events and (index - events[-1][-1][0]) * 1000.0 / rate < gap:
+                events[-1].append((index, level))
+            else:
+                events.append([(index, level)])
+        for event in events:
+            edge = "press" if event[-1][1] else "release"
+            duration = (event[-1][0] - event[0][0]) * 1000.0 / rate
+            result.setdefault((key, edge), []).append(duration)
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", nargs="+", help="capture files or serial device")
+    parser.add_argument("-b", "--baud", type=int, default=115200, help="baud rate of a serial device")
+    parser.add_argument("-g", "--gap", type=float, default=5.0, help="quiet time in ms that ends an event")
+    parser.add_argument("-o", "--output", help="plot the distributions into this file")
+    args = parser.parse_args()
+
+    durations = {}
+    for name in args.source:
+        for line, rate, runs in parse(padlog.read_source(name, args.baud)):
+            for key, values in bounces(line, rate, runs, args.gap).items():
+                durations.setdefault(key, []).extend(values)
+    if not durations:
+        sys.exit("no captures found")
+
+    print("key edge     count  median    p95     max  [ms]")
+    for (key, edge), values in sorted(durations.items()):
+        values.sort()
+        p95 = values[min(len(values) - 1, int(0.95 * len(values)))]
+        print(f"{key}   {edge:8} {len(values):5} {statistics.median(values):7.3f} {p95:7.3f} {values[-1]:7.3f}")
+
+    if args.output:
+        import matplotlib
+        matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+        keys = sorted(durations)
+        fig, axes = plt.subplots(len(keys), 1, figsize=(8, 1.6 * len(keys)), sharex=True, squeeze=False)
+        for axis, key in zip(axes[:, 0], keys):
+            axis.hist(durations[key], bins=50)
+            axis.set_ylabel(f"{key[0]} {key[1]}")
+        axes[-1, 0].set_xlabel("bounce duration [ms]")
+        fig.tight_layout()
+        fig.savefig(args.output)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,63 @@
+"""Reads the output of the keypad firmware shell.
+
+Shell commands which dump binary data write a comment line "# <command>
+<arguments>", then frames and finally the line "# end". This module
+reads such output from a file or a serial device and splits it into
+these blocks. It is shared by the scripts in this directory.
+
+Version: 1.0
+Created: 2026-10-19
+ Author: Wolfgang Neff
+"""
+
+FRAME_START = 0x7E
+
+
+def read_source(name, baud):
+    """Returns the raw bytes of a file or, until interrupted, a serial device."""
+    if name.startswith("/dev/"):
+        import serial
+        data = bytearray()
+        with serial.Serial(name, baud, timeout=1) as port:
+            try:
+                while True:
+                    data += port.read(4096)
+            except KeyboardInterrupt:
+                pass
+        return bytes(data)
+    with open(name, "rb") as f:
+        return f.read()
+
+
+def blocks(data, command, arguments, kind):
+    """Yields (words, payloads) for every block of command in the stream.
+
+    words are the words of the header line without the "#", payloads the
+    payloads of the valid frames of the given kind up to "# end". Header
+    lines with less than the given number of arguments, frames with a
+    wrong checksum and other output are skipped.
+    """
+    i, block = 0, None
+    while i < len(data):
+        c = data[i]
+        if c == ord('#'):
+            end = data.find(b"\n", i)
+            end = len(data) if end < 0 else end
+            words = data[i + 1:end].decode("ascii", "replace").split()
+            if words[:1] == [command] and len(words) > arguments:
+                block = (words, [])
+            elif words[:1] == ["end"] and block:
+                yield block
+                block = None
+            i = end + 1
+        elif c == FRAME_START and i + 3 <= len(data):
+            length = data[i + 2]
+            frame = data[i + 1:i + 4 + length]
+            if len(frame) == length + 3 and sum(frame) % 256 == 0:
+                if frame[0] == kind and block:
+                    block[1].append(frame[2:2 + length])
+                i += length + 4
+            else:
+                i += 1
+        else:
+            i += 1
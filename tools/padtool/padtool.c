@@ -0,0 +1,922 @@
+/*
+ * padtool.c
+ *
+ * Host tool for capturing, replaying, fuzzing and simulating keypad
+ * traffic, for benchmarking the chord recognizer and the event dispatcher
+ * and for checking the key reports and the baud rate calculation.
+ *
+ * Version: 1.0
+ * Created: 2026-10-19
+ *  Author: Wolfgang Neff
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <math.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "baud.h"
+#include "chord.h"
+#include "frame.h"
+#include "keys.h"
+#include "pad.h"
+#include "rate.h"
+#include "report.h"
+
+#define DEFAULT_BAUDRATE 115200
+
+typedef struct {
+	double time;
+	uint16_t state;
+} sample_t;
+
+typedef struct {
+	sample_t *samples;
+	size_t count;
+	size_t size;
+} trace_t;
+
+typedef struct {
+	uint16_t value;
+	uint8_t digits;
+	uint8_t comment;
+	frame_decoder_t frame;
+} decoder_t;
+
+typedef struct {
+	uint16_t pressed;
+	uint16_t released;
+} change_t;
+
+typedef struct {
+	change_t *changes;
+	size_t count;
+	size_t size;
+} changes_t;
+
+static const char *program;
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: %s capture [-b baud] [-o log] source\n"
+		"       %s replay [-s speed] [-p period] [-d depth] log\n"
+		"       %s fuzz [-n runs] [-B bounce%%] [-G ghost%%] [-p period] [-d depth] [-r seed] log\n"
+		"       %s sim [-f fast] [-s slow] [-q quiet] [-d depth] [-c cycles] [-m MHz] log\n"
+		"       %s chord [-n patterns] [-l steps] [-k keys] [-t timeout] [-e events] [-r seed]\n"
+		"       %s report [-n changes] [-D drop%%] [-r seed]\n"
+		"       %s baud [-v]\n"
+		"       %s dispatch [-n subscribers] [-e events] [-r seed]\n"
+		"\n"
+		"source is a serial device, a pty, a file or - for stdin.\n"
+		"speed is a multiple of real time, 0 replays without delay.\n"
+		"replay and fuzz scan the log with period us like the firmware.\n"
+		"sim periods are given in us, the quiet time in ms and cycles per scan.\n"
+		"chord generates random patterns of up to steps steps of up to keys keys.\n"
+		"report drops the given share of the key events before the report.\n"
+		"baud checks usart_params against all register values, -v prints the grid.\n"
+		"dispatch times pad_dispatch over tables of 1 to subscribers entries with mixed masks.\n",
+		program, program, program, program, program, program, program, program);
+	exit(2);
+}
+
+static void die(const char *what)
+{
+	fprintf(stderr, "%s: %s: %s\n", program, what, strerror(errno));
+	exit(1);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Decoding */
+
+static int hexdigit(int c)
+{
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+/* Feeds one byte of the USART stream into the decoder. Returns 1 and
+ * stores the state if a complete "%04x" sample or event frame has been
+ * received. Lines starting with # are comments printed by the firmware. */
+static int decode(decoder_t *decoder, int c, uint16_t *state)
+{
+	int digit = hexdigit(c);
+	if (decoder->frame.state != 0 || c == FRAME_START) {
+		decoder->digits = 0;
+		if (!frame_decode(&decoder->frame, c)) return 0;
+		if (decoder->frame.type != FRAME_EVENT || decoder->frame.length != FRAME_EVENT_SIZE) return 0;
+		*state = decoder->frame.payload[0] | (decoder->frame.payload[1] << 8);
+		return 1;
+	}
+	if (decoder->comment) {
+		if (c == '\n') decoder->comment = 0;
+		return 0;
+	}
+	if (c == '#') {
+		decoder->comment = 1;
+		decoder->digits = 0;
+		return 0;
+	}
+	if (digit < 0) {
+		decoder->digits = 0;
+		return 0;
+	}
+	decoder->value = (decoder->value << 4) | digit;
+	if (++decoder->digits < 4) return 0;
+	decoder->digits = 0;
+	*state = decoder->value;
+	return 1;
+}
+
+/* Traces */
+
+static void trace_add(trace_t *trace, double time, uint16_t state)
+{
+	if (trace->count == trace->size) {
+		trace->size = trace->size ? 2 * trace->size : 1024;
+		trace->samples = realloc(trace->samples, trace->size * sizeof(sample_t));
+		if (!trace->samples) die("realloc");
+	}
+	trace->samples[trace->count].time = time;
+	trace->samples[trace->count].state = state;
+	trace->count++;
+}
+
+static void trace_load(trace_t *trace, const char *name)
+{
+	FILE *file = fopen(name, "r");
+	char line[128];
+	double time;
+	unsigned state;
+	if (!file) die(name);
+	while (fgets(line, sizeof(line), file)) {
+		if (line[0] == '#') continue;
+		if (sscanf(line, "%lf %x", &time, &state) == 2) trace_add(trace, time, state);
+	}
+	fclose(file);
+	if (trace->count == 0) {
+		fprintf(stderr, "%s: %s: no samples\n", program, name);
+		exit(1);
+	}
+}
+
+/* Scans the trace with the given period. Each logged state is held
+ * until the next timestamp, as the firmware would see it. */
+static size_t trace_scan(const trace_t *trace, uint16_t period, uint16_t **samples)
+{
+	double start = trace->samples[0].time, t;
+	size_t count = (size_t)((trace->samples[trace->count - 1].time - start) * 1e6 / period) + 1, i = 0, k;
+
+	*samples = malloc(count * sizeof(uint16_t));
+	if (!*samples) die("malloc");
+	for (k = 0; k < count; k++) {
+		t = start + k * (period / 1e6);
+		while (i + 1 < trace->count && trace->samples[i + 1].time <= t) i++;
+		(*samples)[k] = trace->samples[i].state;
+	}
+	return count;
+}
+
+static void changes_add(changes_t *list, uint16_t pressed, uint16_t released)
+{
+	if (list->count == list->size) {
+		list->size = list->size ? 2 * list->size : 256;
+		list->changes = realloc(list->changes, list->size * sizeof(change_t));
+		if (!list->changes) die("realloc");
+	}
+	list->changes[list->count].pressed = pressed;
+	list->changes[list->count].released = released;
+	list->count++;
+}
+
+static void print_keys(char sign, uint16_t mask)
+{
+	int bit;
+	for (bit = 15; bit >= 0; bit--) {
+		if (mask & (1 << bit)) printf(" %c%c", sign, PAD_KEY_NAMES[bit]);
+	}
+}
+
+/* Capture */
+
+static speed_t baudrate(long baud)
+{
+	switch (baud) {
+		case 9600: return B9600;
+		case 19200: return B19200;
+		case 38400: return B38400;
+		case 57600: return B57600;
+		case 115200: return B115200;
+		case 230400: return B230400;
+		case 460800: return B460800;
+		case 500000: return B500000;
+		case 921600: return B921600;
+		case 1000000: return B1000000;
+		case 2000000: return B2000000;
+	}
+	fprintf(stderr, "%s: unsupported baud rate %ld\n", program, baud);
+	exit(1);
+}
+
+static int capture(int argc, char **argv)
+{
+	long baud = DEFAULT_BAUDRATE;
+	const char *output = NULL;
+	FILE *log = stdout;
+	decoder_t decoder;
+	struct termios tio;
+	unsigned char buffer[256];
+	uint16_t state;
+	ssize_t n, i;
+	int fd, opt;
+
+	while ((opt = getopt(argc, argv, "b:o:")) != -1) {
+		switch (opt) {
+			case 'b': baud = atol(optarg); break;
+			case 'o': output = optarg; break;
+			default: usage();
+		}
+	}
+	if (optind != argc - 1) usage();
+	memset(&decoder, 0, sizeof(decoder));
+
+	if (strcmp(argv[optind], "-") == 0) {
+		fd = STDIN_FILENO;
+	}
+	else {
+		fd = open(argv[optind], O_RDONLY | O_NOCTTY);
+		if (fd < 0) die(argv[optind]);
+	}
+	if (isatty(fd)) {
+		if (tcgetattr(fd, &tio) < 0) die("tcgetattr");
+		cfmakeraw(&tio);
+		cfsetispeed(&tio, baudrate(baud));
+		cfsetospeed(&tio, baudrate(baud));
+		tio.c_cc[VMIN] = 1;
+		tio.c_cc[VTIME] = 0;
+		if (tcsetattr(fd, TCSANOW, &tio) < 0) die("tcsetattr");
+	}
+	if (output) {
+		log = fopen(output, "w");
+		if (!log) die(output);
+	}
+
+	fprintf(log, "# padtool capture of %s\n", argv[optind]);
+	while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+		double time = now();
+		for (i = 0; i < n; i++) {
+			if (decode(&decoder, buffer[i], &state)) {
+				fprintf(log, "%.6f %04x\n", time, state);
+			}
+		}
+		fflush(log);
+	}
+	if (n < 0) die("read");
+	if (log != stdout) fclose(log);
+	return 0;
+}
+
+/* Replay */
+
+static int replay(int argc, char **argv)
+{
+	double speed = 1.0, start, delay, t;
+	int depth = KEYS_DEFAULT_DEPTH, period = SCAN_FAST_PERIOD, opt;
+	trace_t trace = {NULL, 0, 0};
+	keys_t keys;
+	uint16_t *samples, state, previous = 0;
+	size_t i, count;
+
+	while ((opt = getopt(argc, argv, "s:p:d:")) != -1) {
+		switch (opt) {
+			case 's': speed = atof(optarg); break;
+			case 'p': period = atoi(optarg); break;
+			case 'd': depth = atoi(optarg); break;
+			default: usage();
+		}
+	}
+	if (optind != argc - 1 || speed < 0 || period < SCAN_PERIOD_MIN || period > SCAN_PERIOD_MAX) usage();
+	trace_load(&trace, argv[optind]);
+	count = trace_scan(&trace, period, &samples);
+
+	keys_init(&keys, depth);
+	start = now();
+	for (i = 0; i < count; i++) {
+		t = i * (period / 1e6);
+		if (speed > 0) {
+			delay = t / speed - (now() - start);
+			if (delay > 0) usleep((useconds_t)(delay * 1e6));
+		}
+		state = keys_update(&keys, samples[i]);
+		if (state != previous) {
+			printf("%.6f %04x", t, state);
+			print_keys('+', state & ~previous);
+			print_keys('-', ~state & previous);
+			printf("\n");
+			fflush(stdout);
+			previous = state;
+		}
+	}
+	printf("# %zu samples, %zu scans, %u ghosts ignored\n", trace.count, count, keys.ghosts);
+	free(samples);
+	return 0;
+}
+
+/* Fuzz */
+
+static int chance(int percent)
+{
+	return rand() % 100 < percent;
+}
+
+static uint16_t ghost(uint16_t state)
+{
+	int row1 = rand() % 4, row2 = (row1 + 1 + rand() % 3) % 4;
+	int col1 = rand() % 4, col2 = (col1 + 1 + rand() % 3) % 4;
+	uint16_t columns = (1 << col1) | (1 << col2);
+	return state | (columns << (4 * row1)) | (columns << (4 * row2));
+}
+
+static void run(keys_t *keys, const uint16_t *samples, size_t count, changes_t *list)
+{
+	uint16_t state, previous = keys->state;
+	size_t i;
+	list->count = 0;
+	for (i = 0; i < count; i++) {
+		state = keys_update(keys, samples[i]);
+		if (state != previous) changes_add(list, state & ~previous, ~state & previous);
+		previous = state;
+	}
+}
+
+static int fuzz(int argc, char **argv)
+{
+	int runs = 1000, bounce = 20, ghosts = 5, depth = KEYS_DEFAULT_DEPTH, period = SCAN_FAST_PERIOD, opt;
+	int failures = 0, r, k;
+	unsigned seed = (unsigned)time(NULL);
+	trace_t trace = {NULL, 0, 0};
+	changes_t expected = {NULL, 0, 0}, actual = {NULL, 0, 0};
+	uint16_t *clean, *noisy, previous;
+	size_t i, n, limit, count;
+	keys_t keys;
+
+	while ((opt = getopt(argc, argv, "n:B:G:p:d:r:")) != -1) {
+		switch (opt) {
+			case 'n': runs = atoi(optarg); break;
+			case 'B': bounce = atoi(optarg); break;
+			case 'G': ghosts = atoi(optarg); break;
+			case 'p': period = atoi(optarg); break;
+			case 'd': depth = atoi(optarg); break;
+			case 'r': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+			default: usage();
+		}
+	}
+	if (optind != argc - 1 || period < SCAN_PERIOD_MIN || period > SCAN_PERIOD_MAX) usage();
+	trace_load(&trace, argv[optind]);
+	count = trace_scan(&trace, period, &clean);
+
+	/* Bounce inserts at most KEYS_DEPTH_MAX pairs, a ghost one sample. */
+	limit = count * (2 * KEYS_DEPTH_MAX + 2);
+	noisy = malloc(limit * sizeof(uint16_t));
+	if (!noisy) die("malloc");
+
+	keys_init(&keys, depth);
+	run(&keys, clean, count, &expected);
+	if (expected.count == 0) {
+		fprintf(stderr, "%s: %s: no changes at depth %d, nothing to fuzz\n", program, argv[optind], keys.depth);
+		return 1;
+	}
+
+	for (r = 0; r < runs; r++) {
+		srand(seed + r);
+		previous = 0;
+		for (i = 0, n = 0; i < count; i++) {
+			/* Contacts chatter between the old and the new state. The
+			 * chatter ends with the old state so that it never extends
+			 * the run of the new one. */
+			if (clean[i] != previous && chance(bounce)) {
+				for (k = 1 + rand() % KEYS_DEPTH_MAX; k > 0; k--) {
+					noisy[n++] = clean[i];
+					noisy[n++] = previous;
+				}
+			}
+			noisy[n++] = clean[i];
+			if (chance(ghosts)) noisy[n++] = ghost(clean[i]);
+			previous = clean[i];
+		}
+		keys_init(&keys, depth);
+		run(&keys, noisy, n, &actual);
+		if (actual.count != expected.count ||
+			memcmp(actual.changes, expected.changes, actual.count * sizeof(change_t)) != 0) {
+			printf("run %d (seed %u): %zu changes, expected %zu\n", r, seed + r, actual.count, expected.count);
+			failures++;
+		}
+	}
+	printf("# %d runs, %d failures, %zu scans, %zu changes, depth %d\n",
+		runs, failures, count, expected.count, keys.depth);
+	return failures ? 1 : 0;
+}
+
+/* Simulation of the adaptive scan rate */
+
+typedef struct {
+	double duration;
+	uint32_t scans;
+	uint32_t changes;
+	uint32_t missed;
+	double latency;
+	double maximum;
+	rate_t rate;
+} simulation_t;
+
+/* Scans the recorded states with the given rate parameters. The trace
+ * is treated as the true state of the keys. Latency is the time from
+ * a change in the trace until the debounced state reaches it. */
+static void simulate(const trace_t *trace, int depth, uint16_t fast, uint16_t slow, uint16_t quiet, simulation_t *sim)
+{
+	double start = trace->samples[0].time, end = trace->samples[trace->count - 1].time;
+	double t = start, changed = start;
+	uint16_t target = trace->samples[0].state, period, sample;
+	int pending = 0;
+	size_t i = 0;
+	keys_t keys;
+
+	memset(sim, 0, sizeof(*sim));
+	keys_init(&keys, depth);
+	rate_init(&sim->rate, fast, slow, quiet);
+	period = slow;
+	while (t <= end) {
+		while (i + 1 < trace->count && trace->samples[i + 1].time <= t) {
+			i++;
+			if (trace->samples[i].state != target) {
+				if (pending) sim->missed++;
+				target = trace->samples[i].state;
+				changed = trace->samples[i].time;
+				pending = 1;
+			}
+		}
+		sample = trace->samples[i].state;
+		keys_update(&keys, sample);
+		if (pending && keys.state == target) {
+			double latency = t - changed;
+			sim->changes++;
+			sim->latency += latency;
+			if (latency > sim->maximum) sim->maximum = latency;
+			pending = 0;
+		}
+		period = rate_update(&sim->rate, sample || keys_pending(&keys));
+		sim->scans++;
+		t += period / 1e6;
+	}
+	sim->duration = end - start;
+}
+
+static void print_simulation(const char *name, const simulation_t *sim, double cycles, double mhz)
+{
+	uint32_t total = sim->rate.time[RATE_FAST] + sim->rate.time[RATE_SLOW];
+	printf("%-9s %6u %6u %6u  scans %8u  cpu %6.3f%%  latency %6.1f ms max %6.1f ms  missed %u",
+		name, sim->rate.period[RATE_FAST], sim->rate.period[RATE_SLOW], sim->rate.quiet,
+		sim->scans, 100.0 * sim->scans * cycles / (sim->duration * mhz * 1e6),
+		sim->changes ? 1e3 * sim->latency / sim->changes : 0.0, 1e3 * sim->maximum, sim->missed);
+	if (sim->rate.period[RATE_FAST] != sim->rate.period[RATE_SLOW] && total) {
+		printf("  fast %5.1f%%", 100.0 * sim->rate.time[RATE_FAST] / total);
+	}
+	printf("\n");
+}
+
+static int sim(int argc, char **argv)
+{
+	int fast = 2000, slow = 20000, quiet = 250, depth = KEYS_DEFAULT_DEPTH, opt;
+	double cycles = 400, mhz = 2;
+	trace_t trace = {NULL, 0, 0};
+	simulation_t result;
+
+	while ((opt = getopt(argc, argv, "f:s:q:d:c:m:")) != -1) {
+		switch (opt) {
+			case 'f': fast = atoi(optarg); break;
+			case 's': slow = atoi(optarg); break;
+			case 'q': quiet = atoi(optarg); break;
+			case 'd': depth = atoi(optarg); break;
+			case 'c': cycles = atof(optarg); break;
+			case 'm': mhz = atof(optarg); break;
+			default: usage();
+		}
+	}
+	if (optind != argc - 1 || fast <= 0 || fast > slow || slow > 65535) usage();
+	trace_load(&trace, argv[optind]);
+	if (trace.count < 2) {
+		fprintf(stderr, "%s: %s: trace too short\n", program, argv[optind]);
+		return 1;
+	}
+
+	printf("#         fast   slow  quiet  (%.0f cycles per scan at %.1f MHz, depth %d)\n", cycles, mhz, depth);
+	simulate(&trace, depth, fast, fast, quiet, &result);
+	print_simulation("fixed", &result, cycles, mhz);
+	simulate(&trace, depth, slow, slow, quiet, &result);
+	print_simulation("fixed", &result, cycles, mhz);
+	simulate(&trace, depth, fast, slow, quiet, &result);
+	print_simulation("adaptive", &result, cycles, mhz);
+	return 0;
+}
+
+/* Chord recognizer benchmark */
+
+static uint16_t random_step(int keys)
+{
+	uint16_t mask = 0;
+	int k = 1 + rand() % keys;
+	while (k--) mask |= 1 << (rand() % 16);
+	return mask;
+}
+
+static int compare_patterns(const void *a, const void *b)
+{
+	return chord_compare(a, b);
+}
+
+/* Enters the steps of a pattern 100 ms apart and reads the matches
+ * until the timeout has passed. Returns the number of events. */
+static size_t enter(chord_t *chord, const chord_pattern_t *pattern, uint16_t *time, uint8_t *ids, int *matches)
+{
+	size_t events = 0;
+	int s;
+	uint8_t id;
+	*matches = 0;
+	for (s = 0; s < CHORD_STEPS && pattern->step[s]; s++) {
+		chord_event(chord, pattern->step[s], 0, *time);
+		chord_event(chord, 0, pattern->step[s], *time + 50);
+		events += 2;
+		*time += 100;
+	}
+	*time += chord->timeout;
+	while ((id = chord_read(chord, *time)) != CHORD_NONE) ids[(*matches)++ % CHORD_QUEUE_SIZE] = id;
+	return events;
+}
+
+static int chord(int argc, char **argv)
+{
+	int count = 300, steps = 6, keys = 2, timeout = 1000, opt, s, matches, failures = 0;
+	long events = 1000000, done = 0;
+	unsigned seed = (unsigned)time(NULL);
+	chord_pattern_t *table;
+	chord_t recognizer;
+	uint16_t now_ms = 0;
+	uint8_t ids[CHORD_QUEUE_SIZE];
+	double start, elapsed;
+	size_t i, n;
+
+	while ((opt = getopt(argc, argv, "n:l:k:t:e:r:")) != -1) {
+		switch (opt) {
+			case 'n': count = atoi(optarg); break;
+			case 'l': steps = atoi(optarg); break;
+			case 'k': keys = atoi(optarg); break;
+			case 't': timeout = atoi(optarg); break;
+			case 'e': events = atol(optarg); break;
+			case 'r': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+			default: usage();
+		}
+	}
+	if (optind != argc || count < 1 || count > 65535 || steps < 1 || steps > CHORD_STEPS ||
+		keys < 1 || keys > 16 || timeout < 1 || timeout > 60000) usage();
+
+	srand(seed);
+	table = calloc(count, sizeof(chord_pattern_t));
+	if (!table) die("calloc");
+	for (i = 0; i < (size_t)count; i++) {
+		for (s = 1 + rand() % steps; s > 0; s--) table[i].step[s - 1] = random_step(keys);
+	}
+	qsort(table, count, sizeof(chord_pattern_t), compare_patterns);
+	for (i = 0, n = 0; i < (size_t)count; i++) {
+		if (n && chord_compare(&table[n - 1], &table[i]) == 0) continue;
+		table[n] = table[i];
+		table[n].id = 1 + n % 255;
+		n++;
+	}
+	if (!chord_init(&recognizer, table, n, timeout)) {
+		fprintf(stderr, "%s: invalid table\n", program);
+		return 1;
+	}
+
+	/* Every pattern must be reported exactly once, after the timeout if
+	 * a longer pattern begins with it. */
+	for (i = 0; i < n; i++) {
+		enter(&recognizer, &table[i], &now_ms, ids, &matches);
+		if (matches != 1 || ids[0] != table[i].id) {
+			printf("pattern %zu: %d matches, id %u, expected %u\n", i, matches, matches ? ids[0] : 0, table[i].id);
+			failures++;
+		}
+	}
+
+	start = now();
+	for (i = 0; done < events; i = (i + 1) % n) done += enter(&recognizer, &table[i], &now_ms, ids, &matches);
+	elapsed = now() - start;
+
+	for (s = 0; (1UL << s) < n; s++);
+	printf("# %zu patterns (seed %u), %d failures\n", n, seed, failures);
+	printf("# table %zu bytes on the target, recognizer %zu bytes on the host\n",
+		n * (2 * CHORD_STEPS + 1), sizeof(chord_t));
+	printf("# at most %d table reads per step, %.1f ns per event on the host\n", 2 * s, 1e9 * elapsed / done);
+	free(table);
+	return failures ? 1 : 0;
+}
+
+/* Key reports */
+
+static const uint16_t report_modifier_keys[] = {
+	PAD_KEY_STAR_bm, PAD_KEY_HASH_bm, PAD_KEY_A_bm, PAD_KEY_B_bm, PAD_KEY_C_bm, PAD_KEY_D_bm
+};
+
+/* Compares a report with the set of pressed keys. The codes are
+ * compared as a set, unused slots must follow the used ones. */
+static int report_check(const uint8_t *payload, uint16_t state, uint8_t sequence)
+{
+	const char *names = PAD_KEY_NAMES;
+	uint8_t modifiers = 0, codes = 0;
+	uint16_t digits = 0, seen = 0;
+	int k, i;
+	for (k = 0; k < 6; k++) {
+		if (state & report_modifier_keys[k]) modifiers |= 1 << k;
+	}
+	for (k = 0; k < 16; k++) {
+		if ((state & (1 << k)) && names[k] >= '0' && names[k] <= '9') {
+			digits |= 1 << (names[k] - '0');
+			codes++;
+		}
+	}
+	if (payload[0] != sequence || payload[1] != modifiers) return 0;
+	for (i = 0; i < REPORT_KEYS; i++) {
+		if (codes > REPORT_KEYS) {
+			if (payload[2 + i] != REPORT_ROLLOVER) return 0;
+		}
+		else if (i < codes) {
+			k = payload[2 + i] - '0';
+			if (k < 0 || k > 9 || !(digits & (1 << k)) || (seen & (1 << k))) return 0;
+			seen |= 1 << k;
+		}
+		else if (payload[2 + i] != 0) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int report(int argc, char **argv)
+{
+	long changes = 1000000, c, delivered = 0;
+	int drop = 10, opt, failures = 0, key;
+	unsigned seed = (unsigned)time(NULL);
+	uint8_t payload[FRAME_REPORT_SIZE], sequence = 0;
+	uint16_t state = 0;
+	report_t keys;
+
+	while ((opt = getopt(argc, argv, "n:D:r:")) != -1) {
+		switch (opt) {
+			case 'n': changes = atol(optarg); break;
+			case 'D': drop = atoi(optarg); break;
+			case 'r': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+			default: usage();
+		}
+	}
+	if (optind != argc || changes < 1 || drop < 0 || drop > 99) usage();
+
+	srand(seed);
+	report_init(&keys);
+
+	/* A lost release must not leave its code behind: press 1, lose the
+	 * release, press 2. */
+	report_update(&keys, PAD_KEY_1_bm);
+	report_update(&keys, PAD_KEY_2_bm);
+	report_payload(&keys, payload);
+	if (!report_check(payload, PAD_KEY_2_bm, sequence++)) {
+		printf("lost release: %c %c\n", payload[2], payload[3] ? payload[3] : ' ');
+		failures++;
+	}
+	report_update(&keys, 0);
+
+	/* Random presses and releases, up to nine keys at a time to cross
+	 * the rollover. */
+	for (c = 0; c < changes; c++) {
+		key = rand() % 16;
+		if (!(state & (1 << key)) && __builtin_popcount(state) >= 9) continue;
+		state ^= 1 << key;
+		if (chance(drop)) continue;
+		report_update(&keys, state);
+		delivered++;
+		report_payload(&keys, payload);
+		if (!report_check(payload, state, sequence++)) {
+			if (failures++ < 10) printf("change %ld: state %04x\n", c, state);
+		}
+	}
+	printf("# %ld changes, %ld events (%d%% dropped, seed %u), %d failures\n",
+		changes, delivered, drop, seed, failures);
+	return failures ? 1 : 0;
+}
+
+/* Dispatch benchmark */
+
+#define DISPATCH_EVENTS 4096
+
+static unsigned long dispatch_calls;
+
+static void dispatch_count(const scan_event_t *event)
+{
+	(void)event;
+	dispatch_calls++;
+}
+
+/* Masks of whole pad, a row, a column, a single key and the
+ * modifiers in turn, so the table mixes wide and narrow filters. */
+static uint16_t dispatch_mask(int kind)
+{
+	switch (kind % 5) {
+		case 0: return PAD_KEYS_ALL;
+		case 1: return 0x000F << 4 * (rand() % 4);
+		case 2: return 0x1111 << rand() % 4;
+		case 3: return 1 << rand() % 16;
+		default: return PAD_KEY_STAR_bm | PAD_KEY_HASH_bm | PAD_KEY_A_bm | PAD_KEY_B_bm | PAD_KEY_C_bm | PAD_KEY_D_bm;
+	}
+}
+
+static int dispatch(int argc, char **argv)
+{
+	int count = 16, opt, n, i, expected, failures = 0;
+	long events = 1000000, done;
+	unsigned seed = (unsigned)time(NULL);
+	pad_subscriber_t table[255];
+	scan_event_t *list;
+	uint16_t state = 0, key;
+	unsigned long calls;
+	double start, elapsed;
+	size_t e;
+
+	while ((opt = getopt(argc, argv, "n:e:r:")) != -1) {
+		switch (opt) {
+			case 'n': count = atoi(optarg); break;
+			case 'e': events = atol(optarg); break;
+			case 'r': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+			default: usage();
+		}
+	}
+	if (optind != argc || count < 1 || count > 255 || events < 1) usage();
+
+	srand(seed);
+	for (i = 0; i < count; i++) {
+		table[i].mask = dispatch_mask(i);
+		table[i].handler = dispatch_count;
+	}
+	/* One key changes per event, as with a scan period shorter than
+	 * the time between two changes. */
+	list = calloc(DISPATCH_EVENTS, sizeof(scan_event_t));
+	if (!list) die("calloc");
+	for (e = 0; e < DISPATCH_EVENTS; e++) {
+		key = 1 << rand() % 16;
+		state ^= key;
+		list[e].state = state;
+		list[e].pressed = state & key;
+		list[e].released = ~state & key;
+		list[e].time = e;
+	}
+
+	printf("# subscribers  calls/event  ns/event  ns/subscriber  (seed %u)\n", seed);
+	for (n = 1; n <= count; n++) {
+		/* Every subscriber whose mask contains the key is called once. */
+		for (e = 0; e < DISPATCH_EVENTS; e++) {
+			for (i = 0, expected = 0; i < n; i++) {
+				if (table[i].mask & (list[e].pressed | list[e].released)) expected++;
+			}
+			calls = dispatch_calls;
+			if (pad_dispatch(table, n, &list[e]) != expected || dispatch_calls - calls != (unsigned long)expected) {
+				if (failures++ < 10) printf("%d subscribers, event %zu: expected %d calls\n", n, e, expected);
+			}
+		}
+		calls = dispatch_calls;
+		start = now();
+		for (done = 0; done < events; done++) pad_dispatch(table, n, &list[done % DISPATCH_EVENTS]);
+		elapsed = now() - start;
+		printf("%13d  %11.2f  %8.1f  %13.2f\n", n, (double)(dispatch_calls - calls) / done,
+			1e9 * elapsed / done, 1e9 * elapsed / done / n);
+	}
+	printf("# %d subscribers, %ld events each, %d failures\n", count, events, failures);
+	free(list);
+	return failures ? 1 : 0;
+}
+
+/* Baud rate calculation */
+
+static const double baud_clocks[] = {
+	2e6, 4e6, 8e6, 12e6, 14.7456e6, 16e6, 18.432e6, 24e6, 32e6
+};
+
+static const long baud_rates[] = {
+	300, 600, 1200, 2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 76800,
+	115200, 230400, 250000, 460800, 500000, 921600, 1000000, 2000000, 4000000
+};
+
+/* The exact rate of the register values, see the data sheet. */
+static double baud_exact(double freq, int bsel, int bscale, int clk2x)
+{
+	double div = clk2x ? 8 : 16;
+	if (bscale >= 0) return freq / (ldexp(1, bscale) * (bsel + 1) * div);
+	return freq / (div * (ldexp(1, bscale) * bsel + 1));
+}
+
+/* The smallest deviation in per mill of all register values. */
+static double baud_best(double freq, long baud)
+{
+	double best = -1, deviation;
+	int b, s, x;
+	for (x = 0; x <= 1; x++) {
+		for (s = -7; s <= 7; s++) {
+			for (b = 0; b < (1 << USART_BSEL_BITS); b++) {
+				deviation = fabs(1000 * (baud_exact(freq, b, s, x) - baud) / baud);
+				if (best < 0 || deviation < best) best = deviation;
+			}
+		}
+	}
+	return best;
+}
+
+/* usart_params must find a value as good as the best one within the
+ * rounding of usart_baud, report its deviation and reject only the
+ * rates which no value can reach within USART_BAUD_TOLERANCE. */
+static int baud(int argc, char **argv)
+{
+	int verbose = 0, opt, bsel, bscale, clk2x, deviation, failures = 0, valid = 0;
+	double best, actual, worst = 0;
+	size_t c, r;
+
+	while ((opt = getopt(argc, argv, "v")) != -1) {
+		switch (opt) {
+			case 'v': verbose = 1; break;
+			default: usage();
+		}
+	}
+	if (optind != argc) usage();
+
+	for (c = 0; c < sizeof(baud_clocks) / sizeof(baud_clocks[0]); c++) {
+		for (r = 0; r < sizeof(baud_rates) / sizeof(baud_rates[0]); r++) {
+			long freq = (long)baud_clocks[c], rate = baud_rates[r];
+			deviation = usart_params(freq, rate, &bsel, &bscale, &clk2x);
+			best = baud_best(baud_clocks[c], rate);
+			if (bsel < 0) {
+				if (rate <= freq / 8 && best <= USART_BAUD_TOLERANCE - 0.5) {
+					printf("%8.4f MHz %7ld: rejected, %.1f%%o possible\n", freq / 1e6, rate, best);
+					failures++;
+				}
+				else if (verbose) {
+					printf("%8.4f MHz %7ld: rejected\n", freq / 1e6, rate);
+				}
+				continue;
+			}
+			actual = 1000 * (baud_exact(baud_clocks[c], bsel, bscale, clk2x) - rate) / rate;
+			valid++;
+			if (fabs(actual) > worst) worst = fabs(actual);
+			if (verbose) {
+				printf("%8.4f MHz %7ld: bsel %4d bscale %2d clk2x %d  %+6.2f%%o (best %.2f%%o)\n",
+					freq / 1e6, rate, bsel, bscale, clk2x, actual, best);
+			}
+			if (fabs(actual) > best + 0.5 || fabs(actual - deviation) > 1 || fabs(actual) > USART_BAUD_TOLERANCE + 0.5) {
+				printf("%8.4f MHz %7ld: bsel %d bscale %d clk2x %d, %+.2f%%o reported %+d%%o, best %.2f%%o\n",
+					freq / 1e6, rate, bsel, bscale, clk2x, actual, deviation, best);
+				failures++;
+			}
+		}
+	}
+	printf("# %zu clocks, %zu rates, %d valid, worst %.2f%%o, %d failures\n",
+		c, r, valid, worst, failures);
+	return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+	program = argv[0];
+	if (argc < 2) usage();
+	argc--;
+	argv++;
+	if (strcmp(argv[0], "capture") == 0) return capture(argc, argv);
+	if (strcmp(argv[0], "replay") == 0) return replay(argc, argv);
+	if (strcmp(argv[0], "fuzz") == 0) return fuzz(argc, argv);
+	if (strcmp(argv[0], "sim") == 0) return sim(argc, argv);
+	if (strcmp(argv[0], "chord") == 0) return chord(argc, argv);
+	if (strcmp(argv[0], "report") == 0) return report(argc, argv);
+	if (strcmp(argv[0], "baud") == 0) return baud(argc, argv);
+	if (strcmp(argv[0], "dispatch") == 0) return dispatch(argc, argv);
+	usage();
+	return 2;
+}
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""Converts trace dumps of the firmware into the Chrome trace format.
+
+Reads the output of the shell command "trace" from a file or a serial
+device and writes a JSON file which can be opened with chrome://tracing
+or https://ui.perfetto.dev. Interrupts and main loop stages are shown
+as two threads. Time stamps are unwrapped under the assumption that
+consecutive records are less than 65536 timer ticks apart.
+
+Version: 1.0
+Created: 2026-10-19
+ Author: Wolfgang Neff
+"""
+
+import argparse
+import json
+import sys
+
+import padlog
+
+FRAME_TRACE = ord('T')
+EXIT_BM = 0x80
+
+# Trace points in trace.h: id -> (name, thread)
+POINTS = {
+    1: ("timer isr", "isr"),
+    2: ("pad_scan", "isr"),
+    3: ("usart rxc isr", "isr"),
+    4: ("usart dre isr", "isr"),
+    5: ("events", "main"),
+    6: ("output_task", "main"),
+    7: ("shell", "main"),
+    8: ("stats", "main"),
+    9: ("pad_dispatch", "main"),
+}
+THREADS = {"main": 1, "isr": 2}
+
+
+def parse(data):
+    """Yields (clock, records) for every dump in the stream."""
+    for words, payloads in padlog.blocks(data, "trace", 2, FRAME_TRACE):
+        records = [(payload[k], payload[k + 1] | payload[k + 2] << 8)
+                   for payload in payloads for k in range(0, len(payload) - 2, 3)]
+        yield int(words[2]), records
+
+
+def events(clock, records, offset):
+    """Returns the Chrome trace events of one dump starting at offset in microseconds."""
+    result, stacks, time, previous = [], {}, 0, None
+    for ident, stamp in records:
+        if previous is not None:
+            time += (stamp - previous) & 0xFFFF
+        previous = stamp
+        name, thread = POINTS.get(ident & ~EXIT_BM, (f"id {ident & ~EXIT_BM}", "main"))
+        stack = stacks.setdefault(thread, [])
+        ts = offset + time * 1e6 / clock
+        if ident & EXIT_BM:
+            if name not in stack:
+                continue  # entered before the oldest record
+            while stack:
+                top = stack.pop()
+                result.append({"name": top, "ph": "E", "ts": ts, "pid": 1, "tid": THREADS[thread]})
+                if top == name:
+                    break
+        else:
+            stack.append(name)
+            result.append({"name": name, "ph": "B", "ts": ts, "pid": 1, "tid": THREADS[thread]})
+    end = offset + time * 1e6 / clock
+    for thread, stack in stacks.items():
+        while stack:
+            result.append({"name": stack.pop(), "ph": "E", "ts": end, "pid": 1, "tid": THREADS[thread]})
+    return result, end
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="trace dump file or serial device")
+    parser.add_argument("-b", "--baud", type=int, default=115200, help="baud rate of a serial device")
+    parser.add_argument("-o", "--output", help="JSON file (default: standard output)")
+    args = parser.parse_args()
+
+    trace = [{"name": "thread_name", "ph": "M", "pid": 1, "tid": tid, "args": {"name": name}}
+             for name, tid in THREADS.items()]
+    offset, dumps = 0.0, 0
+    for clock, records in parse(padlog.read_source(args.source, args.baud)):
+        result, offset = events(clock, records, offset)
+        trace.extend(result)
+        offset += 1000.0  # separate consecutive dumps by a millisecond
+        dumps += 1
+    if not dumps:
+        sys.exit("no trace found")
+
+    output = open(args.output, "w") if args.output else sys.stdout
+    json.dump({"traceEvents": trace, "displayTimeUnit": "ns"}, output)
+    if args.output:
+        output.close()
+
+
+if __name__ == "__main__":
+    main()